@@ -94,19 +94,19 @@ static int get_memory_size (void)
 static int get_fb_size (const char *path, int id)
 {
     FILE *fp;
-    int x, y;
+    int x = 0, y = 0;
 
     if (access (path, R_OK) == 0) {
         if ((fp = fopen(path, "r")) != NULL) {
-            char rdata[16], *ptr;
+            char rdata[16], *ptr, *save;
 
             memset (rdata, 0x00, sizeof(rdata));
 
             if (fgets (rdata, sizeof(rdata), fp) != NULL) {
-                if ((ptr = strtok (rdata, ",")) != NULL)
+                if ((ptr = strtok_r (rdata, ",", &save)) != NULL)
                     x = atoi(ptr);
 
-                if ((ptr = strtok (NULL, ",")) != NULL)
+                if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
                     y = atoi(ptr);
             }
             fclose(fp);
@@ -166,7 +166,7 @@ static void default_config_write (const char *fname)
 static void default_config_read (void)
 {
     FILE *fp;
-    char fname [STR_PATH_LENGTH +1], value [STR_PATH_LENGTH +1], *ptr;
+    char fname [STR_PATH_LENGTH +1], value [STR_PATH_LENGTH +1], *ptr, *save;
 
     memset  (fname, 0, STR_PATH_LENGTH);
     sprintf (fname, "%sjig-%s.cfg", CONFIG_FILE_PATH, "system");
@@ -189,11 +189,11 @@ static void default_config_read (void)
                 break;
             default :
                 // res_x, res_y, fb_path
-                if ((ptr = strtok (value, ",")) != NULL)
+                if ((ptr = strtok_r (value, ",", &save)) != NULL)
                     DeviceSYSTEM.res_x = atoi (ptr);
-                if ((ptr = strtok ( NULL, ",")) != NULL)
+                if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
                     DeviceSYSTEM.res_y = atoi (ptr);
-                if ((ptr = strtok ( NULL, ",")) != NULL) {
+                if ((ptr = strtok_r (NULL, ",", &save)) != NULL) {
                     memset (DeviceSYSTEM.fb_path, 0, STR_PATH_LENGTH);
                     strcpy (DeviceSYSTEM.fb_path, ptr);
                 }
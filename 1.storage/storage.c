@@ -31,10 +31,15 @@
 #include <getopt.h>
 #include <pthread.h>
 #include <sys/sysinfo.h>
+#include <sys/statvfs.h>
+#include <dirent.h>
 
 //------------------------------------------------------------------------------
 #include "../lib_dev_check.h"
 #include "storage.h"
+#include "storage_io.h"
+#include "storage_mmc.h"
+#include "storage_scan.h"
 
 //------------------------------------------------------------------------------
 struct device_storage {
@@ -45,6 +50,9 @@ struct device_storage {
 
     // read value
     int value;
+
+    // 1 = path를 /sys/block scan 결과로 설정 (cfg dev_node = auto)
+    int scan;
 };
 
 /* Device default r/w speed (MB/s) */
@@ -69,100 +77,1286 @@ struct device_storage {
 //------------------------------------------------------------------------------
 // Boot device define (uSD)
 #define BOOT_DEVICE     eSTORAGE_uSD
-#define TEMP_FILE       "/tmp/wdat"
+// boot device에 mount된 file system에 생성되는 test file
+#define BOOT_TEMP_FILE  ".jig-wdat"
+
+// mmcblk 번호는 boot 순서에 따라 바뀌므로 /sys/block scan 결과를 사용함.
+#define STORAGE_AUTO    "auto"
 
 struct device_storage DeviceSTORAGE [eSTORAGE_END] = {
-    // path, r_min(MB/s), w_min(MB/s), read
+    // path, r_min(MB/s), w_min(MB/s), read, scan
     // eSTORAGE_EMMC
-    { "/dev/mmcblk0", DEFAULT_EMMC_R, DEFAULT_EMMC_W,   0 },
+    { STORAGE_AUTO, DEFAULT_EMMC_R, DEFAULT_EMMC_W,   0, 1 },
     // eSTORAGE_uSD (boot device : /root)
-    { "/dev/mmcblk1",  DEFAULT_uSD_R,  DEFAULT_uSD_R,   0 },
+    { STORAGE_AUTO,  DEFAULT_uSD_R,  DEFAULT_uSD_R,   0, 1 },
     // eSTORAGE_SATA
-    {            " ", DEFAULT_SATA_R, DEFAULT_SATA_R,   0 },
+    { STORAGE_AUTO, DEFAULT_SATA_R, DEFAULT_SATA_R,   0, 1 },
     // eSTORAGE_NVME
-    { "/dev/nvme0n1", DEFAULT_NVME_R, DEFAULT_NVME_R,   0 },
+    { STORAGE_AUTO, DEFAULT_NVME_R, DEFAULT_NVME_R,   0, 1 },
+};
+
+// dev_id별 storage_scan type
+static const int StorageBlkType [eSTORAGE_END] = { eBLK_EMMC, eBLK_SD, eBLK_SATA, eBLK_NVME };
+// 마지막 scan 시간 (초). 없는 device의 반복 check시 scan은 1초에 1번만 실행.
+static time_t StorageScanTime = 0;
+
+// Storage Read / Write io setting (jig-storage.cfg "io" line)
+struct storage_io {
+    // block size (KB), total size (MB), queue depth
+    int bs_kb, size_mb, qd;
+};
+
+#define DEFAULT_IO_BS_KB    (DEFAULT_SIO_BS   / 1024)
+#define DEFAULT_IO_SIZE_MB  (DEFAULT_SIO_SIZE / 1024 / 1024)
+
+struct storage_io StorageIO = { DEFAULT_IO_BS_KB, DEFAULT_IO_SIZE_MB, DEFAULT_SIO_QD };
+
+// Random 4K io setting (jig-storage.cfg "rio" line)
+struct storage_rio {
+    // 측정 시간 (ms), queue depth, offset 범위 (MB), mixed write 비율 (%)
+    int time_ms, qd, span_mb, mix;
+};
+
+#define RIO_BS              4096
+
+struct storage_rio StorageRIO = { 3000, 32, 256, 30 };
+
+// Random 4K 판정 기준 (jig-storage.cfg "rand" line)
+struct storage_rand {
+    // read/write IOPS min, p99 latency max (us)
+    int r_iops, w_iops, p99_max;
+};
+
+/* Device default random 4K IOPS, p99 latency (us) */
+struct storage_rand StorageRAND [eSTORAGE_END] = {
+    // r_iops, w_iops, p99_max
+    // eSTORAGE_EMMC
+    {  2000,   500,  50000 },
+    // eSTORAGE_uSD
+    {   500,   100, 200000 },
+    // eSTORAGE_SATA
+    {  5000,  2000,  20000 },
+    // eSTORAGE_NVME
+    { 20000, 10000,  10000 },
+};
+
+// Sustained r/w setting (jig-storage.cfg "sus" line)
+struct storage_sus {
+    // 측정 시간 (ms, 0 = span 1회), r/w 영역 (MB), window (ms), drop 판정 (%),
+    // 최소 window 판정 (기준 MB/s 대비 %)
+    int time_ms, span_mb, window_ms, drop_pct, min_pct;
+};
+
+struct storage_sus StorageSUS = { 30000, 64, SIO_SERIES_WINDOW, SIO_SERIES_DROP, 50 };
+
+// eMMC/uSD bus mode 기준 (jig-storage.cfg "mmc" line). "mmc" line이 없으면 확인 안함.
+struct storage_mmc {
+    // timing spec min (eMMC_TIMING_xxx), bus width (bits, 0 = 확인 안함), clock min (MHz)
+    int timing, width, clock;
+};
+
+struct storage_mmc StorageMMC [eSTORAGE_END] = {
+    { 0, 0, 0 },
+    { 0, 0, 0 },
+    { 0, 0, 0 },
+    { 0, 0, 0 },
+};
+
+// NVMe PCIe link 기준 (jig-storage.cfg "pcie" line)
+struct storage_pcie {
+    // generation (1 = 2.5 GT/s, 2 = 5 GT/s, 3 = 8 GT/s ...), lane (0 = 확인 안함),
+    // multi-queue read min (link 대역폭 대비 %)
+    int gen, width, pct;
+};
+
+struct storage_pcie StoragePCIE [eSTORAGE_END] = {
+    // eSTORAGE_EMMC, eSTORAGE_uSD, eSTORAGE_SATA
+    { 0, 0, 0 },
+    { 0, 0, 0 },
+    { 0, 0, 0 },
+    // eSTORAGE_NVME : PCIe 2.0 x1 (ODROID-M1S)
+    { 2, 1, 60 },
 };
 
-// Storage Read / Write (16 Mbytes, 1 block count)
-#define STORAGE_R_CHECK "dd of=/dev/null bs=16M count=1 iflag=nocache,dsync oflag=nocache,dsync if="
-#define STORAGE_W_CHECK "dd if=/dev/zero bs=16M count=1 iflag=nocache,dsync oflag=nocache,dsync of="
+// PCIe generation별 lane 대역폭 (MB/s, encoding 제외)
+static const int PcieLaneMBps [] = { 0, 250, 500, 985, 1969, 3938, 7877 };
+#define PCIE_GEN_MAX    ((int)(sizeof(PcieLaneMBps) / sizeof(PcieLaneMBps[0])) -1)
+
+// Full-surface read scan setting (jig-storage.cfg "surf" line)
+struct storage_surf {
+    // region 크기 (MB), queue depth, latency outlier 판정 (region p99 평균 대비 배수, 최소 ms)
+    int region_mb, qd, outlier_x, outlier_ms;
+};
+
+struct storage_surf StorageSURF = { 64, 8, 10, 50 };
+
+// boot file system metadata (create/write 4K/fsync/unlink) setting (jig-storage.cfg "meta" line)
+struct storage_meta {
+    // 측정 시간 (ms), worker thread 수, ops/sec min, fsync p99 latency max (us)
+    int time_ms, threads, ops_min, p99_max;
+};
+
+#define META_THREAD_MAX     16
+#define META_FILE_SIZE      4096
+
+struct storage_meta StorageMETA = { 5000, 4, 50, 100000 };
+
+// raw device write 검증 영역 offset (MB, jig-storage.cfg "scratch" line). -1 = partition map에서 선택
+int StorageScratch [eSTORAGE_END] = { -1, -1, -1, -1 };
+
+// scratch 영역 align 및 device 끝의 제외 영역 크기 (GPT backup header)
+#define SCRATCH_ALIGN       (1024 * 1024)
+#define SCRATCH_PART_MAX    32
+
+// 'A'(all storage) 측정 중에는 다른 storage check를 실행하지 않음.
+static pthread_rwlock_t StorageLock = PTHREAD_RWLOCK_INITIALIZER;
+
+// 같은 controller를 사용하는 device 중 가장 작은 device id. (storage_map_update에서 설정)
+static int StorageCtrl [eSTORAGE_END] = { 0, 1, 2, 3 };
+static pthread_mutex_t StorageCtrlMutex = PTHREAD_MUTEX_INITIALIZER;
 
 //------------------------------------------------------------------------------
+// block device가 연결된 controller의 sysfs path. 확인할 수 없는 경우 path를 그대로 사용.
+// /dev/mmcblk0 : /sys/devices/platform/fe310000.mmc (/mmc_host/...)
+// /dev/nvme0n1 : /sys/devices/pci0000:00/0000:00:00.0/0000:01:00.0 (/nvme/...)
+// /dev/sda     : ata controller (/ata1/...) 또는 usb bus (.../usb2)
 //------------------------------------------------------------------------------
-static int remove_tmp (const char *path)
+static void storage_ctrl_path (const char *path, char *ctrl)
 {
+    const char *mark[] = { "/mmc_host/", "/nvme/", "/ata", "/host", "/block/", NULL };
+    char sys[STR_PATH_LENGTH *2 +1], *ptr;
+    int i;
+
+    strcpy (ctrl, path);
+    if (strncmp (path, "/dev/", strlen ("/dev/")))
+        return;
+
+    snprintf (sys, sizeof(sys), "/sys/class/block/%s", path + strlen ("/dev/"));
+    if (realpath (sys, ctrl) == NULL) {
+        strcpy (ctrl, path);
+        return;
+    }
+
+    // usb storage는 같은 root hub(bus)의 device가 bandwidth를 공유함.
+    if (((ptr = strstr (ctrl, "/usb")) != NULL) && isdigit (ptr[4])) {
+        if ((ptr = strchr (ptr +1, '/')) != NULL)
+            *ptr = 0;
+        return;
+    }
+    for (i = 0; mark[i] != NULL; i++) {
+        if ((ptr = strstr (ctrl, mark[i])) != NULL) {
+            *ptr = 0;
+            return;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// cfg path가 auto인 device의 path(/dev/xxx)를 /sys/block scan 결과로 설정.
+// device_check에서는 설정된 path를 그대로 사용함.
+//------------------------------------------------------------------------------
+static void storage_map_update (void)
+{
+    struct blk_info info;
+    char ctrl [eSTORAGE_END][PATH_MAX];
+    int i, j;
+
+    // StorageScanTime, DeviceSTORAGE[].path는 StorageLock으로 보호됨.
+    pthread_rwlock_wrlock (&StorageLock);
+    StorageScanTime = time (NULL);
+    storage_scan ();
+
+    for (i = 0; i < eSTORAGE_END; i++) {
+        if (!DeviceSTORAGE[i].scan)
+            continue;
+
+        memset (DeviceSTORAGE[i].path, 0, sizeof(DeviceSTORAGE[i].path));
+        if (storage_scan_find (StorageBlkType[i], 0, &info))
+            sprintf (DeviceSTORAGE[i].path, "/dev/%s", info.name);
+        else
+            strcpy (DeviceSTORAGE[i].path, " ");
+    }
+
+    // device별 controller (device_check_lane에서 매번 realpath를 실행하지 않도록 저장)
+    for (i = 0; i < eSTORAGE_END; i++)
+        storage_ctrl_path (DeviceSTORAGE[i].path, ctrl[i]);
+
+    pthread_mutex_lock (&StorageCtrlMutex);
+    for (i = 0; i < eSTORAGE_END; i++) {
+        for (j = 0; (j < i) && strcmp (ctrl[i], ctrl[j]); j++)
+            ;
+        StorageCtrl[i] = j;
+    }
+    pthread_mutex_unlock (&StorageCtrlMutex);
+    pthread_rwlock_unlock (&StorageLock);
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// return MB/s. extended resp = MB/s, IOPS, avg latency(us)
+//------------------------------------------------------------------------------
+static int storage_rw (const char *path, int mode)
+{
+    struct sio_param  param;
+    struct sio_result result;
+
+    sio_param_init (&param, mode);
+    param.bs   = StorageIO.bs_kb * 1024;
+    param.size = (long long)StorageIO.size_mb * 1024 * 1024;
+    param.qd   = StorageIO.qd;
+
+    if (!storage_io_run (path, &param, &result))
+        return 0;
+
+    device_resp_ext ("%d,%d,%d", result.mbps, result.iops, result.lat_avg);
+    return result.mbps;
+}
+
+//------------------------------------------------------------------------------
+// boot device(partition 포함)에 mount된 rw file system의 test file name.
+// mount point가 여러개인 경우 가장 짧은 mount point (/ 우선)를 사용함.
+// return 0 = mount 되지 않았거나 file system 여유 공간이 need(bytes) 보다 작음.
+//------------------------------------------------------------------------------
+static int storage_boot_file (char *fname, long long need)
+{
+    char line[1024], mnt[256], opt[64], best[256], sys[64], real[PATH_MAX], key[64], *ptr;
+    const char *name = strrchr (DeviceSTORAGE[BOOT_DEVICE].path, '/');
+    unsigned int major, minor;
+    struct statvfs vfs;
     FILE *fp;
-    char cmd[STR_PATH_LENGTH];
+    int len;
 
-    if (access (path, R_OK) == 0) {
-        memset  (cmd, 0x00, sizeof(cmd));
-        sprintf (cmd, "rm -f %s 2>&1", path);
+    if ((name == NULL) || ((fp = fopen ("/proc/self/mountinfo", "r")) == NULL))
+        return 0;
+
+    len = snprintf (key, sizeof(key), "/block/%s", name +1);
+    memset (best, 0, sizeof(best));
+
+    while (fgets (line, sizeof(line), fp) != NULL) {
+        // mount_id parent_id major:minor root mount_point mount_options ...
+        if (sscanf (line, "%*d %*d %u:%u %*s %255s %63s", &major, &minor, mnt, opt) != 4)
+            continue;
+        if (strncmp (opt, "rw", 2) || ((opt[2] != ',') && (opt[2] != 0)))
+            continue;
+
+        // /sys/devices/.../block/mmcblk1 or /sys/devices/.../block/mmcblk1/mmcblk1p2
+        snprintf (sys, sizeof(sys), "/sys/dev/block/%u:%u", major, minor);
+        if ((realpath (sys, real) == NULL) || ((ptr = strstr (real, key)) == NULL))
+            continue;
+        if ((ptr[len] != '/') && (ptr[len] != 0))
+            continue;
 
-        if ((fp = popen (cmd, "r")) != NULL) {
-            pclose(fp);
-            return 1;
+        if (!best[0] || (strlen (mnt) < strlen (best)))
+            strcpy (best, mnt);
+    }
+    fclose (fp);
+
+    if (!best[0]) {
+        printf ("%s : %s not mounted!\n", __func__, DeviceSTORAGE[BOOT_DEVICE].path);
+        return 0;
+    }
+    if ((statvfs (best, &vfs) < 0) || ((long long)(vfs.f_bavail * vfs.f_frsize) < need)) {
+        printf ("%s : %s no space! (need %lld bytes)\n", __func__, best, need);
+        return 0;
+    }
+
+    sprintf (fname, "%s/%s", strcmp (best, "/") ? best : "", BOOT_TEMP_FILE);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// sysfs value (long long). return -1 = error
+//------------------------------------------------------------------------------
+static long long sysfs_read_ll (const char *fname)
+{
+    FILE *fp;
+    long long value = -1;
+
+    if ((fp = fopen (fname, "r")) != NULL) {
+        if (fscanf (fp, "%lld", &value) != 1)
+            value = -1;
+        fclose (fp);
+    }
+    return value;
+}
+
+//------------------------------------------------------------------------------
+// block device(name = mmcblk0, mmcblk0p1 ...)가 mount 또는 swap으로 사용중인지 확인.
+//------------------------------------------------------------------------------
+static int storage_mounted (const char *name)
+{
+    char fname[STR_PATH_LENGTH *2 +1], line[1024], dev[32], node[STR_PATH_LENGTH +1];
+    unsigned int major, minor;
+    int used = 0;
+    FILE *fp;
+
+    snprintf (fname, sizeof(fname), "/sys/class/block/%s/dev", name);
+    if ((fp = fopen (fname, "r")) == NULL)
+        return 1;
+    memset (dev, 0, sizeof(dev));
+    fgets  (dev, sizeof(dev), fp);
+    fclose (fp);
+
+    if ((fp = fopen ("/proc/self/mountinfo", "r")) != NULL) {
+        while (!used && (fgets (line, sizeof(line), fp) != NULL)) {
+            if (sscanf (line, "%*d %*d %u:%u", &major, &minor) != 2)
+                continue;
+            snprintf (fname, sizeof(fname), "%u:%u\n", major, minor);
+            used = !strcmp (fname, dev);
         }
+        fclose (fp);
+    }
+    if ((fp = fopen ("/proc/swaps", "r")) != NULL) {
+        snprintf (node, sizeof(node), "/dev/%s", name);
+        while (!used && (fgets (line, sizeof(line), fp) != NULL))
+            used = !strncmp (line, node, strlen (node)) && isspace (line[strlen (node)]);
+        fclose (fp);
+    }
+    return used;
+}
+
+//------------------------------------------------------------------------------
+// raw device write 검증 영역 (bytes offset). return -1 = 사용 가능한 영역 없음
+// 1. partition 사이 또는 마지막 partition 뒤의 빈 영역
+// 2. mount 되지 않은 partition의 중간
+// 첫번째 partition 앞(partition table, bootloader)은 사용하지 않으며,
+// partition이 없는 device는 device의 중간을 사용함.
+//------------------------------------------------------------------------------
+struct storage_part {
+    char name[64];
+    long long start, end;
+};
+
+static long long storage_scratch (const char *path, long long size)
+{
+    struct storage_part part[SCRATCH_PART_MAX], t;
+    char sys[STR_PATH_LENGTH *2 +1], fname[PATH_MAX];
+    const char *name = strrchr (path, '/');
+    long long dev_end, start, end;
+    struct dirent *d;
+    DIR *dir;
+    int i, j, cnt = 0;
+
+    if (name == NULL)
+        return -1;
+    name++;
+
+    snprintf (sys, sizeof(sys), "/sys/class/block/%s", name);
+    snprintf (fname, sizeof(fname), "%s/size", sys);
+    if ((dev_end = sysfs_read_ll (fname) * 512) <= 0)
+        return -1;
+
+    if ((dir = opendir (sys)) == NULL)
+        return -1;
+    while (((d = readdir (dir)) != NULL) && (cnt < SCRATCH_PART_MAX)) {
+        // partition directory (mmcblk0p1, sda1 ...)
+        if (strncmp (d->d_name, name, strlen (name)) || (strlen (d->d_name) >= sizeof(part[0].name)))
+            continue;
+        snprintf (fname, sizeof(fname), "%s/%s/start", sys, d->d_name);
+        if ((start = sysfs_read_ll (fname)) < 0)
+            continue;
+        snprintf (fname, sizeof(fname), "%s/%s/size", sys, d->d_name);
+        if ((end = sysfs_read_ll (fname)) < 0)
+            continue;
+
+        strcpy (part[cnt].name, d->d_name);
+        part[cnt].start = start * 512;
+        part[cnt].end   = (start + end) * 512;
+        cnt++;
+    }
+    closedir (dir);
+
+    if (!cnt) {
+        if (storage_mounted (name) || (dev_end < size * 2))
+            return -1;
+        return (dev_end / 2) & ~(long long)(SCRATCH_ALIGN -1);
+    }
+
+    // start 순서로 정렬
+    for (i = 1; i < cnt; i++) {
+        for (t = part[i], j = i; (j > 0) && (part[j -1].start > t.start); j--)
+            part[j] = part[j -1];
+        part[j] = t;
+    }
+
+    for (end = 0, i = 0; i < cnt; i++) {
+        if (part[i].end > end)
+            end = part[i].end;
+        start = (end + SCRATCH_ALIGN -1) & ~(long long)(SCRATCH_ALIGN -1);
+        if ((start + size) <= ((i +1 < cnt) ? part[i +1].start : (dev_end - SCRATCH_ALIGN)))
+            return start;
+    }
+
+    for (i = 0; i < cnt; i++) {
+        if (((part[i].end - part[i].start) < size * 2) || storage_mounted (part[i].name))
+            continue;
+        return (part[i].start + (part[i].end - part[i].start) / 2) & ~(long long)(SCRATCH_ALIGN -1);
+    }
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+// jig-storage.cfg scratch offset (bytes). -1 = auto
+//------------------------------------------------------------------------------
+static long long storage_scratch_offset (int id)
+{
+    return (StorageScratch[id] < 0) ? -1 : (long long)StorageScratch[id] * 1024 * 1024;
+}
+
+//------------------------------------------------------------------------------
+// scratch 영역(offset < 0 이면 partition map에서 선택)에서 storage_io_verify 실행.
+//------------------------------------------------------------------------------
+int storage_raw_verify (const char *path, long long offset,
+                        struct sio_param *param, struct sio_result *result)
+{
+    if ((param->offset = (offset < 0) ? storage_scratch (path, param->size) : offset) < 0) {
+        printf ("%s : %s scratch area not found! (set jig-storage.cfg scratch)\n", __func__, path);
+        return 0;
+    }
+    return storage_io_verify (path, param, result);
+}
+
+//------------------------------------------------------------------------------
+// scratch 영역(offset < 0 이면 partition map에서 선택)에서 storage_io_sweep 실행.
+//------------------------------------------------------------------------------
+int storage_raw_sweep (const char *path, long long offset, struct sio_param *param,
+                        const int *bs, int n, int *rd, int *wr)
+{
+    if ((param->offset = (offset < 0) ? storage_scratch (path, param->size) : offset) < 0) {
+        printf ("%s : %s scratch area not found! (set jig-storage.cfg scratch)\n", __func__, path);
+        return 0;
     }
-    return 0;
+    return storage_io_sweep (path, param, bs, n, rd, wr);
 }
 
 //------------------------------------------------------------------------------
-static int storage_rw (const char *path, const char *check_cmd)
+// 비파괴 raw device write 검증. offset < 0 이면 partition map에서 영역을 선택.
+// return write MB/s (검증 실패시 0). extended resp = write MB/s, read back MB/s, CRC32C
+//------------------------------------------------------------------------------
+int storage_verify_write (const char *path, long long offset)
 {
+    struct sio_param  param;
+    struct sio_result result;
+
+    sio_param_init (&param, eSIO_WRITE);
+    param.bs   = StorageIO.bs_kb * 1024;
+    param.size = (long long)StorageIO.size_mb * 1024 * 1024;
+    param.qd   = StorageIO.qd;
+
+    if (!storage_raw_verify (path, offset, &param, &result))
+        return 0;
+
+    device_resp_ext ("%d,%d,%08x", result.mbps, result.verify_mbps, result.crc);
+    return result.mbps;
+}
+
+//------------------------------------------------------------------------------
+// Sustained throughput. time_ms 동안 span 영역을 반복 r/w (time_ms = 0 이면 span 1회) 하면서
+// window 단위 MB/s를 기록함. block device write는 scratch 영역을 save/restore 함.
+// return status (평균 >= min, 최소 window >= min * min_pct / 100), value = 평균 MB/s
+// extended resp = 평균, 최소, 마지막 window MB/s, drop 시점 (ms, -1 = 없음)
+//------------------------------------------------------------------------------
+int storage_sustain (const char *path, int mode, int min, long long offset, int *value)
+{
+    struct sio_series series;
+    struct sio_param  param;
+    struct sio_result result;
+    struct stat st;
+    int i, ret;
+
+    sio_series_init (&series, StorageSUS.window_ms, StorageSUS.drop_pct);
+    sio_param_init  (&param, mode);
+    param.bs      = StorageIO.bs_kb * 1024;
+    param.qd      = StorageIO.qd;
+    param.size    = (long long)StorageSUS.span_mb * 1024 * 1024;
+    param.time_ms = StorageSUS.time_ms;
+    param.series  = &series;
+
+    if ((mode == eSIO_WRITE) && !stat (path, &st) && S_ISBLK (st.st_mode))
+        ret = storage_raw_verify (path, offset, &param, &result);
+    else
+        ret = storage_io_run (path, &param, &result);
+
+    if (!ret || !series.windows)
+        return 0;
+
+    printf ("%s : %s %d ms window MB/s (mean %d, min %d, max %d, last %d, drop %d ms)\n",
+        __func__, path, series.window_ms, series.mean, series.min, series.max,
+        series.last, series.drop_ms);
+    for (i = series.count -1; i >= 0; i--)
+        printf ("%d%s", sio_series_get (&series, i),
+            (!i || !((series.count - i) % 20)) ? "\n" : " ");
+
+    device_resp_ext ("%d,%d,%d,%d", series.mean, series.min, series.last, series.drop_ms);
+
+    *value = series.mean;
+    return ((series.mean >= min) && (series.min >= (min * StorageSUS.min_pct / 100))) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// PCIe link (current/max link speed, width)
+//------------------------------------------------------------------------------
+struct pcie_link {
+    int gen, width, max_gen, max_width;
+};
+
+static int pcie_attr (const char *pci, const char *attr, char *value, int size)
+{
+    char fname [PATH_MAX + 32];
     FILE *fp;
-    char cmd[STR_PATH_LENGTH], rdata[STR_PATH_LENGTH], *ptr;
 
-    memset  (cmd, 0x00, sizeof(cmd));
-    sprintf (cmd, "%s%s 2>&1", check_cmd, path);
+    snprintf (fname, sizeof(fname), "%s/%s", pci, attr);
+    if ((fp = fopen (fname, "r")) == NULL)
+        return 0;
 
-    if ((fp = popen (cmd, "r")) != NULL) {
-        while (fgets (rdata, sizeof(rdata), fp) != NULL) {
-            if ((ptr = strstr (rdata, " MB/s")) != NULL) {
-                while (*ptr != ',') ptr--;
-                return atoi (ptr+1);
-            }
+    memset (value, 0, size);
+    fgets  (value, size, fp);
+    fclose (fp);
+    return 1;
+}
+
+// "8.0 GT/s PCIe" -> 3
+static int pcie_gen (const char *speed)
+{
+    double gts = atof (speed), limit = 2.5;
+    int gen;
+
+    for (gen = 1; gen < PCIE_GEN_MAX; gen++, limit *= 2) {
+        // 2.5, 5, 10(8 GT/s), 20(16 GT/s) ...
+        if (gts <= limit + 0.1)
+            break;
+    }
+    return gts ? gen : 0;
+}
+
+static int storage_pcie_read (const char *path, struct pcie_link *link)
+{
+    char pci [PATH_MAX], value [64];
+
+    memset (link, 0, sizeof(struct pcie_link));
+
+    // /sys/devices/pci0000:00/0000:00:00.0/0000:01:00.0
+    storage_ctrl_path (path, pci);
+
+    if (!pcie_attr (pci, "current_link_speed", value, sizeof(value)))
+        return 0;
+    link->gen = pcie_gen (value);
+    if (pcie_attr (pci, "current_link_width", value, sizeof(value)))
+        link->width = atoi (value);
+    if (pcie_attr (pci, "max_link_speed", value, sizeof(value)))
+        link->max_gen = pcie_gen (value);
+    if (pcie_attr (pci, "max_link_width", value, sizeof(value)))
+        link->max_width = atoi (value);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// NVMe PCIe link 확인. return status (-1 = link 정보 없음), value = link 대역폭 (MB/s)
+// extended resp = current gen, width, max gen, width
+//------------------------------------------------------------------------------
+static int storage_pcie (int id, int *value)
+{
+    struct storage_pcie *pcie = &StoragePCIE[id];
+    struct pcie_link link;
+    int status;
+
+    if (!pcie->width)
+        return 1;
+
+    if (!storage_pcie_read (DeviceSTORAGE[id].path, &link)) {
+        printf ("%s : %s pcie link read error!\n", __func__, DeviceSTORAGE[id].path);
+        return -1;
+    }
+    *value = PcieLaneMBps[link.gen] * link.width;
+    status = (link.gen >= pcie->gen) && (link.width >= pcie->width);
+
+    printf ("%s : %s Gen%d x%d (max Gen%d x%d, %d MB/s) %s\n",
+        __func__, DeviceSTORAGE[id].path, link.gen, link.width,
+        link.max_gen, link.max_width, *value, status ? "pass" : "fail");
+
+    device_resp_ext ("%d,%d,%d,%d", link.gen, link.width, link.max_gen, link.max_width);
+    return status;
+}
+
+//------------------------------------------------------------------------------
+// multi-queue read (cpu core별 thread, 각각의 submission queue). return status, value = MB/s
+// extended resp = MB/s, thread 수, PCIe link 대역폭 대비 (%)
+//------------------------------------------------------------------------------
+static int storage_mq (int id, int *value)
+{
+    struct sio_param  param;
+    struct sio_result result;
+    struct pcie_link  link;
+    int threads, pct = 0, status;
+
+    sio_param_init (&param, eSIO_READ);
+    param.bs   = StorageIO.bs_kb * 1024;
+    param.size = (long long)StorageIO.size_mb * 1024 * 1024;
+    param.qd   = StorageIO.qd;
+
+    if (!(threads = storage_io_mq (DeviceSTORAGE[id].path, &param, 0, &result)))
+        return 0;
+
+    if (storage_pcie_read (DeviceSTORAGE[id].path, &link) && link.gen && link.width)
+        pct = result.mbps * 100 / (PcieLaneMBps[link.gen] * link.width);
+
+    status = (result.mbps >= DeviceSTORAGE[id].r_min) &&
+             (!StoragePCIE[id].width || (pct >= StoragePCIE[id].pct));
+
+    printf ("%s : %s %d threads, %d MB/s (%d%% of link), %d iops\n",
+        __func__, DeviceSTORAGE[id].path, threads, result.mbps, pct, result.iops);
+
+    device_resp_ext ("%d,%d,%d", result.mbps, threads, pct);
+
+    *value = result.mbps;
+    return status;
+}
+
+//------------------------------------------------------------------------------
+// timing spec 순위 (속도 순). enum 값은 속도 순서가 아님.
+//------------------------------------------------------------------------------
+static int storage_timing_rank (int timing)
+{
+    switch (timing) {
+        case eMMC_TIMING_MMC_HS400:     return 6;
+        case eMMC_TIMING_MMC_HS200:
+        case eMMC_TIMING_UHS_SDR104:    return 5;
+        case eMMC_TIMING_UHS_SDR50:
+        case eMMC_TIMING_UHS_DDR50:
+        case eMMC_TIMING_MMC_DDR52:     return 4;
+        case eMMC_TIMING_UHS_SDR25:     return 3;
+        case eMMC_TIMING_MMC_HS:
+        case eMMC_TIMING_SD_HS:
+        case eMMC_TIMING_UHS_SDR12:     return 2;
+        case eMMC_TIMING_LEGACY:        return 1;
+        default :                       return 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+// eMMC/uSD bus mode 확인 (host ios, eMMC EXT_CSD), NVMe는 PCIe link 확인.
+// mmc, nvme device가 아니거나 기준이 없으면 1. timing은 기준 이상이면 pass (HS200 기준 -> HS400 pass).
+// return status (-1 = bus mode를 읽을 수 없음), value = actual clock (MHz).
+// extended resp = timing spec, bus width, clock (MHz), EXT_CSD HS_TIMING (SD, 읽기 실패 = -1)
+//------------------------------------------------------------------------------
+static int storage_link (int id, int *value)
+{
+    struct storage_mmc *mmc = &StorageMMC[id];
+    struct mmc_link link;
+    int status, hs_timing, width;
+
+    if (!strncmp (DeviceSTORAGE[id].path, "/dev/nvme", strlen ("/dev/nvme")))
+        return storage_pcie (id, value);
+
+    if (strncmp (DeviceSTORAGE[id].path, "/dev/mmcblk", strlen ("/dev/mmcblk")) || !mmc->width)
+        return 1;
+
+    // debugfs가 mount 되지 않은 경우 등
+    if (!storage_mmc_link (DeviceSTORAGE[id].path, &link)) {
+        printf ("%s : %s bus mode read error!\n", __func__, DeviceSTORAGE[id].path);
+        return -1;
+    }
+    *value = link.actual_clock / 1000000;
+
+    status = (storage_timing_rank (link.timing) >= storage_timing_rank (mmc->timing)) &&
+                (link.width >= mmc->width) && (*value >= mmc->clock);
+
+    // eMMC : host 설정과 card(EXT_CSD) 설정이 같아야 함. (EXT_CSD를 읽지 못한 경우 host 설정만 확인)
+    if (!link.sd && (link.hs_timing >= 0)) {
+        switch (link.timing) {
+            case eMMC_TIMING_MMC_HS400:     hs_timing = 3;  break;
+            case eMMC_TIMING_MMC_HS200:     hs_timing = 2;  break;
+            case eMMC_TIMING_MMC_HS:
+            case eMMC_TIMING_MMC_DDR52:     hs_timing = 1;  break;
+            default :                       hs_timing = 0;  break;
+        }
+        // EXT_CSD BUS_WIDTH : 0 = 1bit, 1 = 4bits, 2 = 8bits (+4 = DDR)
+        switch (link.bus_width & 0x3) {
+            case 2:     width = 8;  break;
+            case 1:     width = 4;  break;
+            default :   width = 1;  break;
+        }
+        if ((link.hs_timing != hs_timing) || (link.width != width))
+            status = 0;
+    }
+
+    printf ("%s : %s %s, %d bits, %d MHz, EXT_CSD HS_TIMING %d BUS_WIDTH %d (%s)\n",
+        __func__, DeviceSTORAGE[id].path, link.timing_str, link.width, *value,
+        link.hs_timing, link.bus_width, status ? "pass" : "fail");
+
+    device_resp_ext ("%d,%d,%d,%d", link.timing, link.width, *value, link.hs_timing);
+    return status;
+}
+
+//------------------------------------------------------------------------------
+// 같은 controller를 사용하는 device 중 가장 작은 device id. (device_check_lane)
+//------------------------------------------------------------------------------
+int storage_controller (int id)
+{
+    int ctrl;
+
+    if ((id < 0) || (id >= eSTORAGE_END))
+        return 0;
+
+    pthread_mutex_lock   (&StorageCtrlMutex);
+    ctrl = StorageCtrl[id];
+    pthread_mutex_unlock (&StorageCtrlMutex);
+    return ctrl;
+}
+
+//------------------------------------------------------------------------------
+// controller별 thread. 같은 controller의 device는 순차적으로 측정함.
+//------------------------------------------------------------------------------
+struct storage_job {
+    pthread_t thread;
+    // 측정할 device (bit mask)
+    int mask;
+    int *value;
+};
+
+static void *storage_ctrl_thread (void *arg)
+{
+    struct storage_job *job = (struct storage_job *)arg;
+    int i;
+
+    for (i = 0; i < eSTORAGE_END; i++) {
+        if (job->mask & (1 << i))
+            job->value[i] = storage_rw (DeviceSTORAGE[i].path, eSIO_READ);
+    }
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+// 연결된 모든 device의 read 속도를 controller별로 동시에 측정. return 측정 device (bit mask)
+//------------------------------------------------------------------------------
+static int storage_read_all (int *value)
+{
+    struct storage_job job [eSTORAGE_END];
+    int i, ctrl, clock, mask = 0;
+
+    memset (job, 0, sizeof(job));
+    for (i = 0; i < eSTORAGE_END; i++) {
+        value[i] = 0;
+        // bus mode 확인이 실패한 device는 측정하지 않음 (bus mode를 읽을 수 없는 경우는 측정)
+        if ((access (DeviceSTORAGE[i].path, R_OK) != 0) || !storage_link (i, &clock))
+            continue;
+
+        ctrl = storage_controller (i);
+        job[ctrl].mask |= (1 << i);
+        job[ctrl].value = value;
+        mask |= (1 << i);
+    }
+
+    for (i = 0; i < eSTORAGE_END; i++) {
+        if (!job[i].mask)
+            continue;
+        // thread 생성 실패시 직접 측정
+        if (pthread_create (&job[i].thread, NULL, storage_ctrl_thread, &job[i])) {
+            storage_ctrl_thread (&job[i]);
+            job[i].mask = 0;
         }
-        pclose(fp);
     }
-    return 0;
+    for (i = 0; i < eSTORAGE_END; i++) {
+        if (job[i].mask)
+            pthread_join (job[i].thread, NULL);
+    }
+    return mask;
+}
+
+//------------------------------------------------------------------------------
+// 모든 device를 1개씩 측정한 값(solo)과 동시에 측정한 값(parallel)을 비교.
+// return status, value = parallel MB/s 합계.
+// extended resp = solo 합계, parallel 합계, device별 parallel/solo (%)
+//------------------------------------------------------------------------------
+static int storage_all (int *value)
+{
+    int solo [eSTORAGE_END], par [eSTORAGE_END], ratio [eSTORAGE_END];
+    int i, mask, solo_sum = 0, par_sum = 0, status = 1;
+
+    mask = storage_read_all (par);
+    for (i = 0; i < eSTORAGE_END; i++) {
+        solo[i] = ratio[i] = 0;
+        if (!(mask & (1 << i)))
+            continue;
+
+        solo[i]   = storage_rw (DeviceSTORAGE[i].path, eSIO_READ);
+        ratio[i]  = solo[i] ? (par[i] * 100 / solo[i]) : 0;
+        solo_sum += solo[i];
+        par_sum  += par[i];
+
+        if (par[i] < DeviceSTORAGE[i].r_min)
+            status = 0;
+
+        printf ("%s : %s (ctrl %d) solo %d MB/s, parallel %d MB/s (%d%%)\n",
+            __func__, DeviceSTORAGE[i].path, storage_controller (i), solo[i], par[i], ratio[i]);
+    }
+
+    device_resp_ext ("%d,%d,%d,%d,%d,%d",
+        solo_sum, par_sum, ratio[eSTORAGE_eMMC], ratio[eSTORAGE_uSD],
+        ratio[eSTORAGE_SATA], ratio[eSTORAGE_NVME]);
+
+    *value = par_sum;
+    return mask ? status : 0;
+}
+
+//------------------------------------------------------------------------------
+// Random 4K (timed). return status, value = IOPS. extended resp = IOPS, p50, p99, p99.9 (us)
+//------------------------------------------------------------------------------
+static int storage_rand (int id, int mode, int *value)
+{
+    struct storage_rand *rand = &StorageRAND[id];
+    struct sio_param  param;
+    struct sio_result result;
+    struct stat st;
+    char fname [STR_PATH_LENGTH *2 +1];
+    int ret, iops_min;
+
+    sio_param_init (&param, mode);
+    param.bs      = RIO_BS;
+    param.qd      = StorageRIO.qd;
+    param.size    = (long long)StorageRIO.span_mb * 1024 * 1024;
+    param.random  = 1;
+    param.mix     = StorageRIO.mix;
+    param.time_ms = StorageRIO.time_ms;
+
+    /* boot device는 boot file system의 test file(span 크기)에서 측정함. */
+    if ((id == BOOT_DEVICE) && (mode != eSIO_READ)) {
+        if (!storage_boot_file (fname, param.size))
+            return 0;
+        ret = storage_io_run (fname, &param, &result);
+        unlink (fname);
+    }
+    /* raw block device write는 scratch 영역에서 실행하고 원래 data를 복구함. */
+    else if ((mode != eSIO_READ) && !stat (DeviceSTORAGE[id].path, &st) && S_ISBLK (st.st_mode)) {
+        if ((param.offset = storage_scratch_offset (id)) < 0)
+            param.offset = storage_scratch (DeviceSTORAGE[id].path, param.size);
+        if (param.offset < 0) {
+            printf ("%s : %s scratch area not found! (set jig-storage.cfg scratch)\n",
+                __func__, DeviceSTORAGE[id].path);
+            return 0;
+        }
+        ret = storage_io_preserve (DeviceSTORAGE[id].path, &param, &result);
+    }
+    else
+        ret = storage_io_run (DeviceSTORAGE[id].path, &param, &result);
+
+    if (!ret)
+        return 0;
+
+    switch (mode) {
+        case eSIO_READ:     iops_min = rand->r_iops;    break;
+        case eSIO_WRITE:    iops_min = rand->w_iops;    break;
+        default :
+            // mixed는 read/write 비율로 기준값 계산
+            iops_min = (rand->r_iops * (100 - param.mix) + rand->w_iops * param.mix) / 100;
+            break;
+    }
+
+    device_resp_ext ("%d,%d,%d,%d",
+        result.iops, result.lat_p50, result.lat_p99, result.lat_p999);
+
+    *value = result.iops;
+    return ((result.iops >= iops_min) && (result.lat_p99 <= rand->p99_max)) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// boot file system metadata test. worker thread별로 time_ms 동안
+// file create -> 4K write -> fsync -> close -> unlink 를 반복함. (1회 = 1 op)
+//------------------------------------------------------------------------------
+struct storage_meta_job {
+    pthread_t thread;
+    const char *dir;
+    int id, ops, error;
+    struct sio_hist hist;
+};
+
+static void *storage_meta_thread (void *arg)
+{
+    struct storage_meta_job *job = (struct storage_meta_job *)arg;
+    struct timespec start, t0, t1;
+    char fname [PATH_MAX], data [META_FILE_SIZE];
+    long long elapsed_ms;
+    int fd;
+
+    memset (data, 0x5A ^ job->id, sizeof(data));
+    clock_gettime (CLOCK_MONOTONIC, &start);
+
+    do {
+        snprintf (fname, sizeof(fname), "%s/t%d-%d", job->dir, job->id, job->ops);
+        if ((fd = open (fname, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644)) < 0) {
+            job->error = errno;
+            break;
+        }
+        if (write (fd, data, sizeof(data)) != sizeof(data))
+            job->error = errno ? errno : EIO;
+
+        clock_gettime (CLOCK_MONOTONIC, &t0);
+        if (fsync (fd) < 0)
+            job->error = errno;
+        clock_gettime (CLOCK_MONOTONIC, &t1);
+
+        close  (fd);
+        unlink (fname);
+        if (job->error)
+            break;
+
+        sio_hist_add (&job->hist,
+            (t1.tv_sec - t0.tv_sec) * 1000000LL + (t1.tv_nsec - t0.tv_nsec) / 1000);
+        job->ops++;
+
+        elapsed_ms = (t1.tv_sec - start.tv_sec) * 1000 + (t1.tv_nsec - start.tv_nsec) / 1000000;
+    } while (elapsed_ms < StorageMETA.time_ms);
+
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+// return status, value = ops/sec. extended resp = ops/sec, fsync p50, p99, p99.9 latency (us)
+//------------------------------------------------------------------------------
+static int storage_meta (int *value)
+{
+    struct storage_meta_job *job;
+    struct sio_hist hist;
+    struct timespec start, end;
+    char dir [STR_PATH_LENGTH *2 +8];
+    int i, j, n, ops = 0, error = 0, elapsed_ms, p50, p99, p999;
+
+    n = (StorageMETA.threads < 1) ? 1 :
+        (StorageMETA.threads > META_THREAD_MAX) ? META_THREAD_MAX : StorageMETA.threads;
+
+    if (!storage_boot_file (dir, (long long)META_FILE_SIZE * n * 16))
+        return 0;
+
+    strcat (dir, ".d");
+    if ((mkdir (dir, 0755) < 0) && (errno != EEXIST)) {
+        printf ("%s : %s mkdir error! (%s)\n", __func__, dir, strerror (errno));
+        return 0;
+    }
+    if ((job = calloc (n, sizeof(struct storage_meta_job))) == NULL) {
+        rmdir (dir);
+        return 0;
+    }
+
+    clock_gettime (CLOCK_MONOTONIC, &start);
+    for (i = 0; i < n; i++) {
+        job[i].dir = dir;
+        job[i].id  = i;
+        // thread 생성 실패시 직접 측정
+        if (pthread_create (&job[i].thread, NULL, storage_meta_thread, &job[i])) {
+            storage_meta_thread (&job[i]);
+            job[i].dir = NULL;
+        }
+    }
+
+    memset (&hist, 0, sizeof(hist));
+    for (i = 0; i < n; i++) {
+        if (job[i].dir != NULL)
+            pthread_join (job[i].thread, NULL);
+        for (j = 0; j < SIO_HIST_SIZE; j++)
+            hist.count[j] += job[i].hist.count[j];
+        hist.total += job[i].hist.total;
+        ops += job[i].ops;
+        if (job[i].error)
+            error = job[i].error;
+    }
+    clock_gettime (CLOCK_MONOTONIC, &end);
+    free  (job);
+    rmdir (dir);
+
+    if (error) {
+        printf ("%s : %s io error! (%s)\n", __func__, dir, strerror (error));
+        return 0;
+    }
+
+    elapsed_ms = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+    *value = elapsed_ms ? (int)(ops * 1000LL / elapsed_ms) : 0;
+    p50  = sio_hist_pct (&hist, 5000);
+    p99  = sio_hist_pct (&hist, 9900);
+    p999 = sio_hist_pct (&hist, 9990);
+
+    printf ("%s : %s %d threads, %d ops, %d ops/sec, fsync p50 %d us, p99 %d us, p99.9 %d us\n",
+        __func__, dir, n, ops, *value, p50, p99, p999);
+    device_resp_ext ("%d,%d,%d,%d", *value, p50, p99, p999);
+
+    return ((*value >= StorageMETA.ops_min) && (p99 <= StorageMETA.p99_max)) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// Full-surface read scan. device 전체를 region 단위로 read 하면서 region별 latency를 확인함.
+// 'F'로 시작하면 background thread에서 실행되며 ('P' 진행률, 'X' 취소)
+// StorageLock, lane을 잡지 않으므로 다른 check는 scan 중에도 실행됨. (throughput 측정값은 낮아짐)
+//------------------------------------------------------------------------------
+enum {
+    eSURF_IDLE = 0,
+    eSURF_RUN,
+    eSURF_DONE,
+    eSURF_CANCEL,
+    eSURF_ERROR,
+};
+
+// io error가 계속되는 경우 (device 제거 등) scan 중지
+#define SURF_ERROR_MAX      16
+// latency 평균 계산에 필요한 최소 region 수 (이전은 outlier_ms 만 확인)
+#define SURF_BASE_REGION    4
+
+struct storage_surface {
+    char path [STR_PATH_LENGTH +1];
+    volatile int cancel;
+    int state, mbps, outliers, errors;
+    // 진행 bytes, device 크기, 가장 느린 io (us) 및 region offset (MB)
+    long long done, total;
+    int worst_us, worst_mb;
+};
+
+static struct storage_surface StorageSurface [eSTORAGE_END];
+static pthread_mutex_t SurfaceMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void *storage_surface_thread (void *arg)
+{
+    struct storage_surface *surf = (struct storage_surface *)arg;
+    struct sio_param  param;
+    struct sio_result result;
+    struct timespec start, now;
+    long long offset, region, p99_sum = 0, elapsed_ms;
+    int ret, regions = 0, base, outlier;
+
+    clock_gettime (CLOCK_MONOTONIC, &start);
+    region = (long long)StorageSURF.region_mb * 1024 * 1024;
+
+    for (offset = 0; (offset < surf->total) && !surf->cancel; offset += region) {
+        sio_param_init (&param, eSIO_READ);
+        param.bs     = StorageIO.bs_kb * 1024;
+        param.qd     = StorageSURF.qd;
+        param.offset = offset;
+        param.size   = ((surf->total - offset) < region) ? (surf->total - offset) : region;
+        param.cancel = &surf->cancel;
+
+        memset (&result, 0, sizeof(result));
+        ret = storage_io_run (surf->path, &param, &result);
+
+        // region p99 평균 대비 느린 io가 있는 region (outlier는 평균 계산에서 제외)
+        base    = regions ? (int)(p99_sum / regions) : 0;
+        outlier = (result.lat_max >= StorageSURF.outlier_ms * 1000) &&
+                    ((regions < SURF_BASE_REGION) || (result.lat_max >= base * StorageSURF.outlier_x));
+
+        clock_gettime (CLOCK_MONOTONIC, &now);
+        elapsed_ms = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+
+        pthread_mutex_lock (&SurfaceMutex);
+        if (!ret && !surf->cancel) {
+            surf->errors++;
+            printf ("%s : %s io error at %lld MB\n", __func__, surf->path, offset >> 20);
+        }
+        if (outlier) {
+            surf->outliers++;
+            printf ("%s : %s latency outlier at %lld MB (max %d us, p99 %d us, base %d us)\n",
+                __func__, surf->path, offset >> 20, result.lat_max, result.lat_p99, base);
+        }
+        else if (result.bytes) {
+            p99_sum += result.lat_p99;
+            regions++;
+        }
+        if (result.lat_max > surf->worst_us) {
+            surf->worst_us = result.lat_max;
+            surf->worst_mb = (int)(offset >> 20);
+        }
+        // 실제 읽은 bytes만 진행으로 계산 (실패/중단 region이 있으면 done < total)
+        surf->done += result.bytes;
+        surf->mbps = elapsed_ms ? (int)(surf->done / 1000 / elapsed_ms) : 0;
+        ret = (surf->errors >= SURF_ERROR_MAX);
+        pthread_mutex_unlock (&SurfaceMutex);
+
+        if (ret)
+            break;
+    }
+
+    pthread_mutex_lock (&SurfaceMutex);
+    if (surf->cancel)
+        surf->state = eSURF_CANCEL;
+    else
+        surf->state = (surf->done < surf->total) ? eSURF_ERROR : eSURF_DONE;
+    printf ("%s : %s scan end. (state %d, %lld/%lld MB, %d MB/s, outlier %d, error %d, worst %d us at %d MB)\n",
+        __func__, surf->path, surf->state, surf->done >> 20, surf->total >> 20, surf->mbps,
+        surf->outliers, surf->errors, surf->worst_us, surf->worst_mb);
+    pthread_mutex_unlock (&SurfaceMutex);
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+// 'F' scan 시작 (실행 중이면 그대로 유지). return 1 = 실행 중, value = 진행률 (%)
+//------------------------------------------------------------------------------
+static int storage_surface_start (int id, int *value)
+{
+    struct storage_surface *surf = &StorageSurface[id];
+    pthread_attr_t attr;
+    pthread_t thread;
+    int status = 1;
+
+    pthread_mutex_lock (&SurfaceMutex);
+    if (surf->state != eSURF_RUN) {
+        memset (surf, 0, sizeof(struct storage_surface));
+        strncpy (surf->path, DeviceSTORAGE[id].path, STR_PATH_LENGTH);
+        surf->state = eSURF_RUN;
+
+        pthread_attr_init (&attr);
+        pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+        if (((surf->total = storage_io_size (surf->path)) <= 0) ||
+            pthread_create (&thread, &attr, storage_surface_thread, surf)) {
+            surf->state = eSURF_ERROR;
+            status = 0;
+        }
+        pthread_attr_destroy (&attr);
+    }
+    *value = surf->total ? (int)(surf->done * 100 / surf->total) : 0;
+    pthread_mutex_unlock (&SurfaceMutex);
+    return status;
+}
+
+//------------------------------------------------------------------------------
+// 'P' 진행률, 'X' 취소. return status (scan 완료, outlier/error 없음), value = 진행률 (%)
+// extended resp = 진행률, MB/s, outlier region 수, error 수, state (0 idle, 1 run, 2 done, 3 cancel, 4 error)
+//------------------------------------------------------------------------------
+static int storage_surface (int id, char action, int *value)
+{
+    struct storage_surface *surf = &StorageSurface[id];
+    int status;
+
+    pthread_mutex_lock (&SurfaceMutex);
+    *value = surf->total ? (int)(surf->done * 100 / surf->total) : 0;
+    status = (surf->state == eSURF_DONE) && !surf->outliers && !surf->errors;
+
+    // 취소 요청은 scan이 실행 중인 경우 성공
+    if (action == 'X') {
+        status = (surf->state == eSURF_RUN);
+        surf->cancel = status;
+    }
+    device_resp_ext ("%d,%d,%d,%d,%d",
+        *value, surf->mbps, surf->outliers, surf->errors, surf->state);
+    pthread_mutex_unlock (&SurfaceMutex);
+    return status;
 }
 
 //------------------------------------------------------------------------------
 int storage_check (int id, char action, char *resp)
 {
-    int value = 0, status = 0;
+    char fname [STR_PATH_LENGTH *2 +1], path [STR_PATH_LENGTH +1];
+    int value = 0, status = 0, rescan;
+
+    if (action == 'A') {
+        pthread_rwlock_wrlock (&StorageLock);
+        status = storage_all (&value);
+        pthread_rwlock_unlock (&StorageLock);
+        sprintf (resp, "%06d", value);
+        return status;
+    }
 
-    if ((id >= eSTORAGE_END) || (access (DeviceSTORAGE[id].path, R_OK) != 0)) {
+    if (id >= eSTORAGE_END) {
         sprintf (resp, "%06d", 0);
         return 0;
     }
 
+    // surface scan 진행률, 취소 (device 상태와 관계없이 응답)
+    if ((action == 'P') || (action == 'X')) {
+        status = storage_surface (id, action, &value);
+        sprintf (resp, "%06d", value);
+        return status;
+    }
+
+    // device가 제거되었거나 번호가 바뀐 경우 다시 scan
+    pthread_rwlock_rdlock (&StorageLock);
+    rescan = DeviceSTORAGE[id].scan && (access (DeviceSTORAGE[id].path, R_OK) != 0) &&
+                (StorageScanTime != time (NULL));
+    if (rescan) {
+        pthread_rwlock_unlock (&StorageLock);
+        storage_map_update ();
+        pthread_rwlock_rdlock (&StorageLock);
+    }
+
+    // path는 read lock 동안 변경되지 않음
+    strncpy (path, DeviceSTORAGE[id].path, STR_PATH_LENGTH);
+    path[STR_PATH_LENGTH] = 0;
+    if (access (path, R_OK) != 0) {
+        pthread_rwlock_unlock (&StorageLock);
+        sprintf (resp, "%06d", 0);
+        return 0;
+    }
+
+    // throughput 측정은 bus mode 확인(eMMC/uSD)이 된 경우만 실행
+    // bus mode를 읽을 수 없는 경우(-1)는 측정을 그대로 실행
+    if ((action != 'I') && (action != 'L') && !storage_link (id, &value)) {
+        printf ("%s : %s bus mode check fail, skip '%c'\n", __func__, path, action);
+        action = 0;
+        value  = 0;
+    }
+    // gate로 실행된 storage_link의 extended resp는 측정 결과가 아니므로 지움
+    else if ((action != 'I') && (action != 'L'))
+        device_resp_ext ("%s", "");
+
     switch (action) {
         case 'I':   case 'R':
             if (action == 'I')
                 value = DeviceSTORAGE[id].value;
             else
-                value = storage_rw (DeviceSTORAGE[id].path, STORAGE_R_CHECK);
+                value = storage_rw (DeviceSTORAGE[id].path, eSIO_READ);
 
             status = (value < DeviceSTORAGE[id].r_min) ? 0 : 1;
             break;
         case 'W':
             /* boot device의 경우 /dev/node를 바로 r/w할 수 없기 때문. */
-            /* tmp파일을 생성하는데 걸리는 시간을 측정함. */
+            /* boot file system(/tmp는 tmpfs)에 test file을 생성하는데 걸리는 시간을 측정함. */
             if (id == BOOT_DEVICE) {
-                value = storage_rw (TEMP_FILE, STORAGE_W_CHECK);
-                remove_tmp (TEMP_FILE);
+                if (storage_boot_file (fname, (long long)StorageIO.size_mb * 1024 * 1024)) {
+                    value = storage_rw (fname, eSIO_WRITE);
+                    unlink (fname);
+                }
             }
             else
-                value = storage_rw (DeviceSTORAGE[id].path, STORAGE_W_CHECK);
+                value = storage_verify_write (DeviceSTORAGE[id].path, storage_scratch_offset (id));
 
             status = (value < DeviceSTORAGE[id].w_min) ? 0 : 1;
             break;
+        // Random 4K read / write / mixed
+        case '1':   case '2':   case '3':
+            status = storage_rand (id, eSIO_READ + (action - '1'), &value);
+            break;
+        // Sustained read / write
+        case '5':
+            status = storage_sustain (DeviceSTORAGE[id].path, eSIO_READ,
+                                        DeviceSTORAGE[id].r_min, -1, &value);
+            break;
+        case '6':
+            if (id == BOOT_DEVICE) {
+                if (storage_boot_file (fname, (long long)StorageSUS.span_mb * 1024 * 1024)) {
+                    status = storage_sustain (fname, eSIO_WRITE, DeviceSTORAGE[id].w_min, -1, &value);
+                    unlink (fname);
+                }
+            }
+            else
+                status = storage_sustain (DeviceSTORAGE[id].path, eSIO_WRITE,
+                                        DeviceSTORAGE[id].w_min, storage_scratch_offset (id), &value);
+            break;
+        // NVMe multi-queue read
+        case 'N':
+            status = storage_mq (id, &value);
+            break;
+        // eMMC/uSD bus mode (timing, bus width, clock), NVMe PCIe link
         case 'L':
+            status = (storage_link (id, &value) > 0) ? 1 : 0;
+            break;
+        // boot file system metadata (create/fsync/unlink)
+        case 'M':
+            if (id == BOOT_DEVICE)
+                status = storage_meta (&value);
+            break;
+        // Full-surface read scan 시작 (background)
+        case 'F':
+            status = storage_surface_start (id, &value);
             break;
         default :
             break;
     }
+    pthread_rwlock_unlock (&StorageLock);
+
     sprintf (resp, "%06d", value);
     return status;
 }
@@ -172,12 +1366,13 @@ static void default_config_write (const char *fname)
 {
     FILE *fp;
     char value [STR_PATH_LENGTH *2 +1];
+    int i;
 
     if ((fp = fopen(fname, "wt")) == NULL)
         return;
 
     // default value write
-    fputs   ("# info : dev_id, dev_node, rd_speed, wr_speed \n", fp);
+    fputs   ("# info : dev_id, dev_node(auto = /sys/block scan), rd_speed, wr_speed \n", fp);
     memset  (value, 0, STR_PATH_LENGTH *2);
     sprintf (value, "%d,%s,%d,%d,\n",
         eSTORAGE_eMMC, DeviceSTORAGE[eSTORAGE_eMMC].path, DEFAULT_EMMC_R, DEFAULT_EMMC_W);
@@ -195,15 +1390,205 @@ static void default_config_write (const char *fname)
         eSTORAGE_NVME, DeviceSTORAGE[eSTORAGE_NVME].path, DEFAULT_NVME_R, DEFAULT_NVME_W);
     fputs   (value, fp);
 
+    // io engine setting
+    fputs   ("# io : block size(KB), total size(MB), queue depth \n", fp);
+    memset  (value, 0, STR_PATH_LENGTH *2);
+    sprintf (value, "io,%d,%d,%d,\n", StorageIO.bs_kb, StorageIO.size_mb, StorageIO.qd);
+    fputs   (value, fp);
+
+    // random 4K setting, device별 판정 기준
+    fputs   ("# rio : time(ms), queue depth, offset range(MB), mixed write(%) \n", fp);
+    memset  (value, 0, STR_PATH_LENGTH *2);
+    sprintf (value, "rio,%d,%d,%d,%d,\n",
+        StorageRIO.time_ms, StorageRIO.qd, StorageRIO.span_mb, StorageRIO.mix);
+    fputs   (value, fp);
+    fputs   ("# rand : dev_id, rd_iops, wr_iops, p99 latency max(us) \n", fp);
+    for (i = 0; i < eSTORAGE_END; i++) {
+        memset  (value, 0, STR_PATH_LENGTH *2);
+        sprintf (value, "rand,%d,%d,%d,%d,\n",
+            i, StorageRAND[i].r_iops, StorageRAND[i].w_iops, StorageRAND[i].p99_max);
+        fputs   (value, fp);
+    }
+
+    // sustained r/w setting
+    fputs   ("# sus : time(ms, 0 = span once), span(MB), window(ms), drop(%), min window(% of min) \n", fp);
+    memset  (value, 0, STR_PATH_LENGTH *2);
+    sprintf (value, "sus,%d,%d,%d,%d,%d,\n", StorageSUS.time_ms, StorageSUS.span_mb,
+        StorageSUS.window_ms, StorageSUS.drop_pct, StorageSUS.min_pct);
+    fputs   (value, fp);
+
+    // eMMC/uSD bus mode
+    fputs   ("# mmc : dev_id, timing spec min(9 = HS200, 10 = HS400, 6 = SDR104), bus width, clock(MHz) \n", fp);
+    fputs   ("# ex) mmc,0,9,8,150,  mmc,1,6,4,100, (line이 없으면 bus mode gate 사용 안함) \n", fp);
+    for (i = 0; i < eSTORAGE_END; i++) {
+        if (!StorageMMC[i].width)
+            continue;
+        memset  (value, 0, STR_PATH_LENGTH *2);
+        sprintf (value, "mmc,%d,%d,%d,%d,\n",
+            i, StorageMMC[i].timing, StorageMMC[i].width, StorageMMC[i].clock);
+        fputs   (value, fp);
+    }
+
+    // NVMe PCIe link
+    fputs   ("# pcie : dev_id, generation, lane, multi-queue read min(% of link) \n", fp);
+    for (i = 0; i < eSTORAGE_END; i++) {
+        if (!StoragePCIE[i].width)
+            continue;
+        memset  (value, 0, STR_PATH_LENGTH *2);
+        sprintf (value, "pcie,%d,%d,%d,%d,\n",
+            i, StoragePCIE[i].gen, StoragePCIE[i].width, StoragePCIE[i].pct);
+        fputs   (value, fp);
+    }
+
+    // boot file system metadata test
+    fputs   ("# meta : time(ms), threads, ops/sec min, fsync p99 latency max(us) \n", fp);
+    memset  (value, 0, STR_PATH_LENGTH *2);
+    sprintf (value, "meta,%d,%d,%d,%d,\n", StorageMETA.time_ms, StorageMETA.threads,
+        StorageMETA.ops_min, StorageMETA.p99_max);
+    fputs   (value, fp);
+
+    // full-surface read scan
+    fputs   ("# surf : region(MB), queue depth, outlier(x region p99 mean), outlier min(ms) \n", fp);
+    memset  (value, 0, STR_PATH_LENGTH *2);
+    sprintf (value, "surf,%d,%d,%d,%d,\n", StorageSURF.region_mb, StorageSURF.qd,
+        StorageSURF.outlier_x, StorageSURF.outlier_ms);
+    fputs   (value, fp);
+
+    // raw device write 검증 영역
+    fputs   ("# scratch : dev_id, write verify offset(MB, -1 = auto) \n", fp);
+    for (i = 0; i < eSTORAGE_END; i++) {
+        memset  (value, 0, STR_PATH_LENGTH *2);
+        sprintf (value, "scratch,%d,%d,\n", i, StorageScratch[i]);
+        fputs   (value, fp);
+    }
+
     // file close
     fclose  (fp);
 }
 
+//------------------------------------------------------------------------------
+// keyword line (첫번째 항목이 문자인 line)
+//------------------------------------------------------------------------------
+static void config_keyword (char *value)
+{
+    char *ptr, *save;
+    int dev_id;
+
+    if ((ptr = strtok_r (value, ",", &save)) == NULL)
+        return;
+
+    if (!strcmp (ptr, "io")) {
+        // io, block size(KB), total size(MB), queue depth
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageIO.bs_kb   = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageIO.size_mb = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageIO.qd      = atoi (ptr);
+    }
+    else if (!strcmp (ptr, "rio")) {
+        // rio, time(ms), queue depth, offset range(MB), mixed write(%)
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageRIO.time_ms = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageRIO.qd      = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageRIO.span_mb = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageRIO.mix     = atoi (ptr);
+    }
+    else if (!strcmp (ptr, "rand")) {
+        // rand, dev_id, rd_iops, wr_iops, p99 latency max(us)
+        if ((ptr = strtok_r (NULL, ",", &save)) == NULL)
+            return;
+        if (((dev_id = atoi (ptr)) < 0) || (dev_id >= eSTORAGE_END))
+            return;
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageRAND[dev_id].r_iops  = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageRAND[dev_id].w_iops  = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageRAND[dev_id].p99_max = atoi (ptr);
+    }
+    else if (!strcmp (ptr, "sus")) {
+        // sus, time(ms), span(MB), window(ms), drop(%), min window(%)
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageSUS.time_ms   = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageSUS.span_mb   = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageSUS.window_ms = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageSUS.drop_pct  = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageSUS.min_pct   = atoi (ptr);
+    }
+    else if (!strcmp (ptr, "mmc")) {
+        // mmc, dev_id, timing spec, bus width, clock(MHz)
+        if ((ptr = strtok_r (NULL, ",", &save)) == NULL)
+            return;
+        if (((dev_id = atoi (ptr)) < 0) || (dev_id >= eSTORAGE_END))
+            return;
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageMMC[dev_id].timing = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageMMC[dev_id].width  = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageMMC[dev_id].clock  = atoi (ptr);
+    }
+    else if (!strcmp (ptr, "pcie")) {
+        // pcie, dev_id, generation, lane, multi-queue read min(%)
+        if ((ptr = strtok_r (NULL, ",", &save)) == NULL)
+            return;
+        if (((dev_id = atoi (ptr)) < 0) || (dev_id >= eSTORAGE_END))
+            return;
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StoragePCIE[dev_id].gen   = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StoragePCIE[dev_id].width = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StoragePCIE[dev_id].pct   = atoi (ptr);
+    }
+    else if (!strcmp (ptr, "meta")) {
+        // meta, time(ms), threads, ops/sec min, fsync p99 latency max(us)
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageMETA.time_ms = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageMETA.threads = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageMETA.ops_min = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageMETA.p99_max = atoi (ptr);
+    }
+    else if (!strcmp (ptr, "surf")) {
+        // surf, region(MB), queue depth, outlier(x), outlier min(ms)
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageSURF.region_mb  = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageSURF.qd         = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageSURF.outlier_x  = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageSURF.outlier_ms = atoi (ptr);
+    }
+    else if (!strcmp (ptr, "scratch")) {
+        // scratch, dev_id, write verify offset(MB, -1 = auto)
+        if ((ptr = strtok_r (NULL, ",", &save)) == NULL)
+            return;
+        if (((dev_id = atoi (ptr)) < 0) || (dev_id >= eSTORAGE_END))
+            return;
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            StorageScratch[dev_id] = atoi (ptr);
+    }
+    else
+        printf ("%s : unknown keyword %s\n", __func__, ptr);
+}
+
 //------------------------------------------------------------------------------
 static void default_config_read (void)
 {
     FILE *fp;
-    char fname [STR_PATH_LENGTH +1], value [STR_PATH_LENGTH +1], *ptr;
+    char fname [STR_PATH_LENGTH +1], value [STR_PATH_LENGTH +1], *ptr, *save;
     int dev_id;
 
     memset  (fname, 0, STR_PATH_LENGTH);
@@ -226,17 +1611,23 @@ static void default_config_read (void)
             case '#':   case '\n':
                 break;
             default :
+                if (isalpha (value[0])) {
+                    config_keyword (value);
+                    break;
+                }
                 // default value write
                 // fputs   ("# info : dev_id, dev_node, rd_speed, wr_speed \n", fp);
-                if ((ptr = strtok (value, ",")) != NULL) {
-                    dev_id = atoi (ptr);
-                    if ((ptr = strtok ( NULL, ",")) != NULL) {
+                if ((ptr = strtok_r (value, ",", &save)) != NULL) {
+                    if (((dev_id = atoi (ptr)) < 0) || (dev_id >= eSTORAGE_END))
+                        break;
+                    if ((ptr = strtok_r (NULL, ",", &save)) != NULL) {
                         memset (DeviceSTORAGE[dev_id].path, 0, STR_PATH_LENGTH);
                         strcpy (DeviceSTORAGE[dev_id].path, ptr);
+                        DeviceSTORAGE[dev_id].scan = !strcmp (ptr, STORAGE_AUTO);
                     }
-                    if ((ptr = strtok ( NULL, ",")) != NULL)
+                    if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
                        DeviceSTORAGE[dev_id].r_min = atoi (ptr);
-                    if ((ptr = strtok ( NULL, ",")) != NULL)
+                    if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
                        DeviceSTORAGE[dev_id].w_min = atoi (ptr);
                 }
                 break;
@@ -248,15 +1639,15 @@ static void default_config_read (void)
 //------------------------------------------------------------------------------
 int storage_grp_init (void)
 {
-    int i;
+    int i, value [eSTORAGE_END];
 
     default_config_read ();
+    storage_map_update  ();
 
-    for (i = 0; i < eSTORAGE_END; i++) {
-        if ((access (DeviceSTORAGE[i].path, R_OK)) == 0)
-            DeviceSTORAGE[i].value =
-                storage_rw (DeviceSTORAGE[i].path, STORAGE_R_CHECK);
-    }
+    // 다른 controller의 device는 동시에 측정
+    storage_read_all (value);
+    for (i = 0; i < eSTORAGE_END; i++)
+        DeviceSTORAGE[i].value = value[i];
 
     return 1;
 }
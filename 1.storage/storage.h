@@ -20,6 +20,17 @@
 //------------------------------------------------------------------------------
 // Define the Device ID for the STORAGE group.
 //------------------------------------------------------------------------------
+// action : 'I' init read speed, 'R' read, 'W' write (MB/s, save/restore 후 CRC32C 검증)
+//          '1' random 4K read, '2' random 4K write, '3' random 4K mixed (IOPS)
+//          '5' sustained read, '6' sustained write (평균 MB/s, window 단위 기록)
+//          'L' eMMC/uSD bus mode (clock MHz), NVMe PCIe link (link MB/s)
+//              (R/W/1~6/N/M/F는 'L' 확인 후 실행)
+//          'N' multi-queue read (cpu core별 thread, MB/s)
+//          'M' boot file system metadata (create/4K write/fsync/unlink, ops/sec. boot device only)
+//          'F' full-surface read scan 시작 (background, 진행률 %)
+//          'P' scan 진행률 (%, 완료 및 latency outlier/io error가 없으면 status 1), 'X' scan 취소
+//          'A' all storage read (parallel MB/s, solo 비교. dev_id 무시)
+//------------------------------------------------------------------------------
 enum {
     // eMMC
     eSTORAGE_eMMC,
@@ -36,8 +47,18 @@ enum {
 //------------------------------------------------------------------------------
 // function prototype
 //------------------------------------------------------------------------------
+struct sio_param;
+struct sio_result;
+
 extern int storage_check     (int id, char action, char *resp);
 extern int storage_grp_init  (void);
+extern int storage_controller(int id);
+extern int storage_verify_write (const char *path, long long offset);
+extern int storage_sustain   (const char *path, int mode, int min, long long offset, int *value);
+extern int storage_raw_verify(const char *path, long long offset,
+                                struct sio_param *param, struct sio_result *result);
+extern int storage_raw_sweep (const char *path, long long offset, struct sio_param *param,
+                                const int *bs, int n, int *rd, int *wr);
 
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
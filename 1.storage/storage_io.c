@@ -0,0 +1,977 @@
+//------------------------------------------------------------------------------
+/**
+ * @file storage_io.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Device Test library for ODROID-JIG. (storage io engine)
+ * @version 0.2
+ * @date 2023-10-12
+ *
+ * @package apt install iperf3, nmap, ethtool, usbutils, alsa-utils
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+// O_DIRECT
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#include <linux/aio_abi.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <nmmintrin.h>
+#elif defined(__aarch64__)
+    #include <sys/auxv.h>
+    #include <asm/hwcap.h>
+    #include <arm_acle.h>
+#endif
+
+//------------------------------------------------------------------------------
+#include "../lib_dev_check.h"
+#include "storage_io.h"
+
+//------------------------------------------------------------------------------
+// linux native aio (libaio 없이 system call 사용)
+//------------------------------------------------------------------------------
+static int sio_setup (unsigned int nr, aio_context_t *ctx)
+{
+    return syscall (__NR_io_setup, nr, ctx);
+}
+
+static int sio_destroy (aio_context_t ctx)
+{
+    return syscall (__NR_io_destroy, ctx);
+}
+
+static int sio_submit (aio_context_t ctx, long nr, struct iocb **iocbs)
+{
+    return syscall (__NR_io_submit, ctx, nr, iocbs);
+}
+
+static int sio_getevents (aio_context_t ctx, long min_nr, long nr, struct io_event *events)
+{
+    return syscall (__NR_io_getevents, ctx, min_nr, nr, events, NULL);
+}
+
+//------------------------------------------------------------------------------
+// CRC32C (Castagnoli). cpu의 crc 명령(SSE4.2, ARMv8 CRC)을 사용하며 지원하지 않으면 table 사용.
+//------------------------------------------------------------------------------
+static unsigned int Crc32cTable[256];
+static unsigned int (*Crc32cFunc) (unsigned int crc, const unsigned char *p, long long size);
+static pthread_once_t Crc32cOnce = PTHREAD_ONCE_INIT;
+
+static unsigned int crc32c_sw (unsigned int crc, const unsigned char *p, long long size)
+{
+    while (size--)
+        crc = (crc >> 8) ^ Crc32cTable[(crc ^ *p++) & 0xFF];
+    return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static unsigned int crc32c_hw (unsigned int crc, const unsigned char *p, long long size)
+{
+    unsigned long long c = crc;
+
+    for (; size && ((unsigned long)p & 7); size--)
+        c = _mm_crc32_u8 (c, *p++);
+    for (; size >= 8; size -= 8, p += 8)
+        c = _mm_crc32_u64 (c, *(const unsigned long long *)p);
+    for (; size; size--)
+        c = _mm_crc32_u8 (c, *p++);
+    return c;
+}
+
+static int crc32c_hw_support (void)
+{
+    return __builtin_cpu_supports ("sse4.2");
+}
+#elif defined(__aarch64__)
+__attribute__((target("+crc")))
+static unsigned int crc32c_hw (unsigned int crc, const unsigned char *p, long long size)
+{
+    for (; size && ((unsigned long)p & 7); size--)
+        crc = __crc32cb (crc, *p++);
+    for (; size >= 8; size -= 8, p += 8)
+        crc = __crc32cd (crc, *(const unsigned long long *)p);
+    for (; size; size--)
+        crc = __crc32cb (crc, *p++);
+    return crc;
+}
+
+static int crc32c_hw_support (void)
+{
+    return (getauxval (AT_HWCAP) & HWCAP_CRC32) ? 1 : 0;
+}
+#endif
+
+static void crc32c_init (void)
+{
+    unsigned int i, j, c;
+
+    for (i = 0; i < 256; i++) {
+        for (c = i, j = 0; j < 8; j++)
+            c = (c & 1) ? ((c >> 1) ^ 0x82F63B78) : (c >> 1);
+        Crc32cTable[i] = c;
+    }
+    Crc32cFunc = crc32c_sw;
+#if defined(__x86_64__) || defined(__aarch64__)
+    if (crc32c_hw_support ())
+        Crc32cFunc = crc32c_hw;
+#endif
+}
+
+//------------------------------------------------------------------------------
+unsigned int sio_crc32c (const void *data, long long size)
+{
+    pthread_once (&Crc32cOnce, crc32c_init);
+    return Crc32cFunc (0xFFFFFFFF, (const unsigned char *)data, size) ^ 0xFFFFFFFF;
+}
+
+//------------------------------------------------------------------------------
+static long long now_us (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+//------------------------------------------------------------------------------
+struct sio_ctx {
+    int fd;
+    struct sio_param  *param;
+    struct sio_result *result;
+
+    // io buffer (queue depth * block size)
+    char *buf;
+
+    // next io offset, end offset, 남은 io size (time_ms = 0)
+    long long next, end, remain;
+    // random offset block count, time_ms 종료 시간
+    long long blocks, deadline;
+    unsigned long long rand;
+    // 1 = io error or end of device, error = io error (측정 실패)
+    int stop, error;
+
+    long long ops, lat_sum;
+    struct sio_hist hist;
+
+    // param series : 현재 window 시작 시간, 완료 bytes
+    long long w_start, w_bytes;
+};
+
+//------------------------------------------------------------------------------
+// latency histogram
+//------------------------------------------------------------------------------
+#define HIST_HALF   (1 << (SIO_HIST_SUB_BITS -1))
+
+static int hist_index (long long us)
+{
+    int shift;
+
+    if (us < (1 << SIO_HIST_SUB_BITS))
+        return (us < 0) ? 0 : us;
+    if (us > 0x7FFFFFFF)
+        us = 0x7FFFFFFF;
+
+    // 상위 SIO_HIST_SUB_BITS bit로 bucket 결정
+    shift = (31 - __builtin_clz ((unsigned int)us)) - (SIO_HIST_SUB_BITS -1);
+    return shift * HIST_HALF + (us >> shift);
+}
+
+//------------------------------------------------------------------------------
+// bucket 최대값
+//------------------------------------------------------------------------------
+static int hist_value (int idx)
+{
+    int shift;
+
+    if (idx < (1 << SIO_HIST_SUB_BITS))
+        return idx;
+
+    shift = idx / HIST_HALF -1;
+    return ((idx % HIST_HALF + HIST_HALF) << shift) + (1 << shift) -1;
+}
+
+//------------------------------------------------------------------------------
+void sio_hist_add (struct sio_hist *hist, long long us)
+{
+    hist->count[hist_index (us)]++;
+    hist->total++;
+}
+
+//------------------------------------------------------------------------------
+// pct_x100 : percentile * 100 (p50 = 5000, p99 = 9900, p99.9 = 9990). return us
+//------------------------------------------------------------------------------
+int sio_hist_pct (struct sio_hist *hist, int pct_x100)
+{
+    long long target, sum = 0;
+    int i;
+
+    if (!hist->total)
+        return 0;
+
+    if ((target = (hist->total * pct_x100 + 9999) / 10000) < 1)
+        target = 1;
+
+    for (i = 0; i < SIO_HIST_SIZE; i++)
+        if ((sum += hist->count[i]) >= target)
+            return hist_value (i);
+
+    return hist_value (SIO_HIST_SIZE -1);
+}
+
+//------------------------------------------------------------------------------
+// throughput time series (window 단위 MB/s)
+//------------------------------------------------------------------------------
+void sio_series_init (struct sio_series *series, int window_ms, int drop_pct)
+{
+    memset (series, 0, sizeof(struct sio_series));
+    series->window_ms = (window_ms > 0) ? window_ms : SIO_SERIES_WINDOW;
+    series->drop_pct  = (drop_pct  > 0) ? drop_pct  : SIO_SERIES_DROP;
+    series->drop_ms   = -1;
+}
+
+//------------------------------------------------------------------------------
+// return n번째 이전 window MB/s (0 = 마지막 window)
+//------------------------------------------------------------------------------
+int sio_series_get (struct sio_series *series, int n)
+{
+    if (n >= series->count)
+        return 0;
+
+    return series->mbps[(series->head + SIO_SERIES_MAX -1 - n) % SIO_SERIES_MAX];
+}
+
+//------------------------------------------------------------------------------
+// 처음 SIO_SERIES_BASE window의 평균을 기준으로 최근 3 window의 평균이 drop_pct 이하로
+// 떨어진 첫 시점을 drop_ms로 기록함.
+//------------------------------------------------------------------------------
+static void sio_series_add (struct sio_series *series, int mbps)
+{
+    int avg;
+
+    series->mbps[series->head] = mbps;
+    series->head = (series->head +1) % SIO_SERIES_MAX;
+    if (series->count < SIO_SERIES_MAX)
+        series->count++;
+
+    if (!series->windows || (mbps < series->min))  series->min = mbps;
+    if (mbps > series->max)                         series->max = mbps;
+
+    series->sum  += mbps;
+    series->last  = mbps;
+    series->windows++;
+    series->mean  = series->sum / series->windows;
+
+    if (series->windows == SIO_SERIES_BASE)
+        series->base = series->mean;
+
+    if ((series->windows >= SIO_SERIES_BASE + 3) && (series->drop_ms < 0)) {
+        avg = (sio_series_get (series, 0) + sio_series_get (series, 1) +
+               sio_series_get (series, 2)) / 3;
+        if (avg < (series->base * series->drop_pct / 100))
+            series->drop_ms = (series->windows -3) * series->window_ms;
+    }
+}
+
+//------------------------------------------------------------------------------
+// io 완료 bytes를 window에 추가. 완료된 io가 없는 window는 0 MB/s로 기록됨.
+//------------------------------------------------------------------------------
+static void sio_window (struct sio_ctx *c, long long now, int bytes)
+{
+    struct sio_series *series = c->param->series;
+    long long w_us = (long long)series->window_ms * 1000;
+
+    while (now >= (c->w_start + w_us)) {
+        sio_series_add (series, c->w_bytes / w_us);
+        c->w_start += w_us;
+        c->w_bytes  = 0;
+    }
+    c->w_bytes += bytes;
+}
+
+//------------------------------------------------------------------------------
+// xorshift64*
+//------------------------------------------------------------------------------
+static unsigned long long sio_rand (struct sio_ctx *c)
+{
+    c->rand ^= c->rand >> 12;
+    c->rand ^= c->rand << 25;
+    c->rand ^= c->rand >> 27;
+    return c->rand * 2685821657736338717ULL;
+}
+
+//------------------------------------------------------------------------------
+static void sio_done (struct sio_ctx *c, long long lat, int bytes)
+{
+    struct sio_result *r = c->result;
+
+    if (!c->ops || (lat < r->lat_min))  r->lat_min = lat;
+    if (lat > r->lat_max)               r->lat_max = lat;
+
+    sio_hist_add (&c->hist, lat);
+    if (c->param->series)
+        sio_window (c, now_us (), bytes);
+
+    r->bytes   += bytes;
+    c->lat_sum += lat;
+    c->ops++;
+}
+
+//------------------------------------------------------------------------------
+// 다음 io offset, size, write(1)/read(0). return 0 = 완료
+//------------------------------------------------------------------------------
+static int sio_next (struct sio_ctx *c, long long *offset, int *write)
+{
+    struct sio_param *p = c->param;
+    int size = p->bs;
+
+    if (c->stop || (p->cancel && *p->cancel))
+        return 0;
+    if (p->time_ms ? (now_us () >= c->deadline) : (c->remain <= 0))
+        return 0;
+
+    if (p->random)
+        *offset = p->offset + (long long)(sio_rand (c) % c->blocks) * p->bs;
+    else {
+        // time_ms 동안 반복
+        if (c->next >= c->end)
+            c->next = p->offset;
+        if ((c->end - c->next) < size)
+            size = c->end - c->next;
+
+        *offset  = c->next;
+        c->next += size;
+    }
+    c->remain -= size;
+
+    if (p->mode == eSIO_MIXED)
+        *write = (int)(sio_rand (c) % 100) < p->mix;
+    else
+        *write = (p->mode == eSIO_WRITE);
+
+    return size;
+}
+
+//------------------------------------------------------------------------------
+// io buffer. param data가 있는 경우 offset 위치의 data를 사용.
+//------------------------------------------------------------------------------
+static char *sio_buf (struct sio_ctx *c, int slot, long long offset)
+{
+    if (c->param->data)
+        return c->param->data + (offset - c->param->offset);
+
+    return c->buf + (long)slot * c->param->bs;
+}
+
+//------------------------------------------------------------------------------
+static int sio_run_sync (struct sio_ctx *c)
+{
+    long long offset, start;
+    int size, ret, write;
+
+    while ((size = sio_next (c, &offset, &write)) > 0) {
+        // EINTR은 같은 offset을 다시 실행
+        do {
+            start = now_us ();
+            if (write)
+                ret = pwrite (c->fd, sio_buf (c, 0, offset), size, offset);
+            else
+                ret = pread  (c->fd, sio_buf (c, 0, offset), size, offset);
+        } while ((ret < 0) && (errno == EINTR));
+
+        if (ret < 0) {
+            printf ("%s : io error at %lld! (%s)\n", __func__, offset, strerror (errno));
+            c->error = 1;
+            break;
+        }
+        // end of device
+        if (ret == 0)
+            break;
+        sio_done (c, now_us () - start, ret);
+
+        // end of device
+        if (ret < size)
+            break;
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static void sio_prep (struct sio_ctx *c, struct iocb *cb, int slot, long long offset, int size,
+                        int write)
+{
+    memset (cb, 0, sizeof(struct iocb));
+    cb->aio_data       = slot;
+    cb->aio_lio_opcode = write ? IOCB_CMD_PWRITE : IOCB_CMD_PREAD;
+    cb->aio_fildes     = c->fd;
+    cb->aio_buf        = (unsigned long)sio_buf (c, slot, offset);
+    cb->aio_nbytes     = size;
+    cb->aio_offset     = offset;
+}
+
+//------------------------------------------------------------------------------
+// return submit count
+//------------------------------------------------------------------------------
+static int sio_submit_all (struct sio_ctx *c, aio_context_t ctx, struct iocb **list, int cnt,
+                            long long *start)
+{
+    long long t = now_us ();
+    int i, ret, done = 0;
+
+    for (i = 0; i < cnt; i++)
+        start[list[i]->aio_data] = t;
+
+    while (done < cnt) {
+        if ((ret = sio_submit (ctx, cnt - done, list + done)) <= 0) {
+            if ((ret < 0) && ((errno == EINTR) || (errno == EAGAIN)))
+                continue;
+            printf ("%s : io submit error! (%s)\n", __func__, strerror (errno));
+            c->stop = c->error = 1;
+            break;
+        }
+        done += ret;
+    }
+    return done;
+}
+
+//------------------------------------------------------------------------------
+// return 0 = native aio 사용 불가
+//------------------------------------------------------------------------------
+static int sio_run_aio (struct sio_ctx *c)
+{
+    aio_context_t ctx = 0;
+    struct iocb cb[SIO_QD_MAX], *list[SIO_QD_MAX];
+    struct io_event ev[SIO_QD_MAX];
+    long long start[SIO_QD_MAX], offset, t;
+    int qd = c->param->qd, i, n, cnt, size, slot, inflight, write;
+
+    if (sio_setup (qd, &ctx) < 0)
+        return 0;
+
+    c->result->aio = 1;
+
+    for (cnt = 0, i = 0; i < qd; i++) {
+        if ((size = sio_next (c, &offset, &write)) <= 0)
+            break;
+        sio_prep (c, &cb[i], i, offset, size, write);
+        list[cnt++] = &cb[i];
+    }
+    inflight = sio_submit_all (c, ctx, list, cnt, start);
+
+    while (inflight > 0) {
+        if ((n = sio_getevents (ctx, 1, qd, ev)) < 0) {
+            if (errno == EINTR)
+                continue;
+            c->error = 1;
+            break;
+        }
+        t = now_us ();
+
+        for (cnt = 0, i = 0; i < n; i++) {
+            slot = ev[i].data;
+            inflight--;
+
+            // io error, end of device
+            if (ev[i].res <= 0) {
+                if (ev[i].res < 0) {
+                    printf ("%s : io error at %lld! (%s)\n", __func__,
+                        (long long)cb[slot].aio_offset, strerror (-ev[i].res));
+                    c->error = 1;
+                }
+                c->stop = 1;
+                continue;
+            }
+            sio_done (c, t - start[slot], ev[i].res);
+            if (ev[i].res < (long long)cb[slot].aio_nbytes)
+                c->stop = 1;
+
+            if ((size = sio_next (c, &offset, &write)) > 0) {
+                sio_prep (c, &cb[slot], slot, offset, size, write);
+                list[cnt++] = &cb[slot];
+            }
+        }
+        inflight += sio_submit_all (c, ctx, list, cnt, start);
+    }
+    sio_destroy (ctx);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// block device = device size, file = file size
+//------------------------------------------------------------------------------
+static long long sio_dev_size (int fd, int *is_blk)
+{
+    unsigned long long size = 0;
+    struct stat st;
+
+    if (fstat (fd, &st) < 0)
+        return 0;
+
+    if ((*is_blk = S_ISBLK (st.st_mode))) {
+        if (ioctl (fd, BLKGETSIZE64, &size) < 0)
+            return 0;
+        return size;
+    }
+    return st.st_size;
+}
+
+//------------------------------------------------------------------------------
+// block device, file 크기 (bytes). return 0 = error
+//------------------------------------------------------------------------------
+long long storage_io_size (const char *path)
+{
+    long long size;
+    int fd, is_blk;
+
+    if ((fd = open (path, O_RDONLY | O_CLOEXEC)) < 0)
+        return 0;
+
+    size = sio_dev_size (fd, &is_blk);
+    close (fd);
+    return size;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+void sio_param_init (struct sio_param *param, int mode)
+{
+    memset (param, 0, sizeof(struct sio_param));
+    param->mode = mode;
+    param->bs   = DEFAULT_SIO_BS;
+    param->qd   = DEFAULT_SIO_QD;
+    param->size = DEFAULT_SIO_SIZE;
+}
+
+//------------------------------------------------------------------------------
+// path (block device or file) io 속도 측정. return 1 = success (io error가 있으면 0)
+// 측정 범위는 device 크기로 제한되며, file의 random/mixed write는 size 만큼 공간을 할당함.
+// write는 zero data를 기록하므로 block device의 data는 지워짐. (dd if=/dev/zero와 같음)
+//------------------------------------------------------------------------------
+int storage_io_run (const char *path, struct sio_param *param, struct sio_result *result)
+{
+    struct sio_ctx c;
+    long long start, dev_size;
+    int flags, is_blk = 0;
+
+    memset (result, 0, sizeof(struct sio_result));
+    memset (&c, 0, sizeof(c));
+
+    // O_DIRECT align
+    param->bs      = (param->bs < SIO_ALIGN) ? SIO_ALIGN : (param->bs & ~(SIO_ALIGN -1));
+    param->qd      = (param->qd < 1) ? 1 : ((param->qd > SIO_QD_MAX) ? SIO_QD_MAX : param->qd);
+    param->offset &= ~(long long)(SIO_ALIGN -1);
+    param->size   &= ~(long long)(SIO_ALIGN -1);
+
+    if (param->mode == eSIO_READ)
+        flags = O_RDONLY;
+    else
+        flags = ((param->mode == eSIO_WRITE) ? O_WRONLY : O_RDWR) | O_CREAT | O_DSYNC;
+    flags |= O_CLOEXEC;
+
+    result->direct = 1;
+    if ((c.fd = open (path, flags | O_DIRECT, 0644)) < 0) {
+        // O_DIRECT를 지원하지 않는 file system (tmpfs 등)
+        if ((errno != EINVAL) || ((c.fd = open (path, flags, 0644)) < 0)) {
+            printf ("%s : %s open error! (%s)\n", __func__, path, strerror (errno));
+            return 0;
+        }
+        result->direct = 0;
+        posix_fadvise (c.fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+
+    if (posix_memalign ((void **)&c.buf, SIO_ALIGN, (size_t)param->bs * param->qd)) {
+        close (c.fd);
+        return 0;
+    }
+    memset (c.buf, 0, (size_t)param->bs * param->qd);
+
+    c.param  = param;
+    c.result = result;
+    c.next   = param->offset;
+    c.end    = param->offset + param->size;
+    c.rand   = (now_us () ^ (unsigned long)&c) | 1;
+
+    // 측정 범위를 device(file) 크기로 제한. file random write는 미리 공간을 할당.
+    dev_size = sio_dev_size (c.fd, &is_blk);
+    if (!is_blk && (param->mode != eSIO_READ) && (param->random || (param->mode == eSIO_MIXED))) {
+        if ((dev_size < c.end) && !posix_fallocate (c.fd, 0, c.end))
+            dev_size = c.end;
+    }
+    if ((is_blk || (param->mode != eSIO_WRITE)) && (c.end > dev_size))
+        c.end = dev_size & ~(long long)(SIO_ALIGN -1);
+
+    c.remain = c.end - param->offset;
+    c.blocks = c.remain / param->bs;
+    if ((c.remain <= 0) || (param->random && !c.blocks) ||
+        (param->data && param->random)) {
+        printf ("%s : %s out of range! (size = %lld)\n", __func__, path, dev_size);
+        free  (c.buf);
+        close (c.fd);
+        return 0;
+    }
+
+    start = now_us ();
+    c.deadline = start + (long long)param->time_ms * 1000;
+    c.w_start  = start;
+    if (param->series)
+        sio_series_init (param->series, param->series->window_ms, param->series->drop_pct);
+
+    if ((param->qd < 2) || !sio_run_aio (&c))
+        sio_run_sync (&c);
+
+    if (!result->direct && (param->mode == eSIO_WRITE))
+        fdatasync (c.fd);
+    result->elapsed_us = now_us () - start;
+
+    // 마지막 window (window의 절반 이상 진행된 경우)
+    if (param->series) {
+        long long w_us = (long long)param->series->window_ms * 1000;
+
+        sio_window (&c, start + result->elapsed_us, 0);
+        if ((start + result->elapsed_us - c.w_start) >= (w_us / 2))
+            sio_series_add (param->series, c.w_bytes / (start + result->elapsed_us - c.w_start));
+    }
+
+    if (result->elapsed_us > 0) {
+        result->mbps = result->bytes / result->elapsed_us;
+        result->iops = (c.ops * 1000000) / result->elapsed_us;
+    }
+    if (c.ops)
+        result->lat_avg = c.lat_sum / c.ops;
+
+    result->lat_p50  = sio_hist_pct (&c.hist, 5000);
+    result->lat_p99  = sio_hist_pct (&c.hist, 9900);
+    result->lat_p999 = sio_hist_pct (&c.hist, 9990);
+
+    free  (c.buf);
+    close (c.fd);
+    return (result->bytes && !c.error) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// xorshift64 pattern (8 bytes 단위)
+//------------------------------------------------------------------------------
+static void sio_pattern (char *data, long long size)
+{
+    unsigned long long *p = (unsigned long long *)data, x = (now_us () << 1) | 1;
+    long long i;
+
+    for (i = 0; i < size / 8; i++) {
+        x ^= x << 13;   x ^= x >> 7;    x ^= x << 17;
+        p[i] = x;
+    }
+}
+
+//------------------------------------------------------------------------------
+// 비파괴 write 검증. param offset 부터 size 영역의 data를 저장한 뒤 pattern을 기록하고,
+// O_DIRECT로 다시 읽어 CRC32C를 비교한 다음 원래 data를 복구함.
+// param time_ms, series는 pattern write에만 적용됨. (time_ms 동안 같은 영역을 반복 기록)
+// result = pattern write 결과 (verify_mbps, crc 포함). return 1 = 검증 성공
+//------------------------------------------------------------------------------
+int storage_io_verify (const char *path, struct sio_param *param, struct sio_result *result)
+{
+    struct sio_result rd;
+    struct sio_series *series = param->series;
+    char *save = NULL, *pattern = NULL;
+    unsigned int crc;
+    long long size;
+    int ret = 0, time_ms = param->time_ms, written;
+
+    memset (result, 0, sizeof(struct sio_result));
+
+    // time_ms, series는 pattern write에만 적용
+    param->random  = param->time_ms = 0;
+    param->series  = NULL;
+    param->offset &= ~(long long)(SIO_ALIGN -1);
+    param->size   &= ~(long long)(SIO_ALIGN -1);
+    if ((size = param->size) <= 0)
+        return 0;
+
+    if (posix_memalign ((void **)&save,    SIO_ALIGN, size) ||
+        posix_memalign ((void **)&pattern, SIO_ALIGN, size)) {
+        printf ("%s : memory alloc error! (%lld bytes)\n", __func__, size);
+        goto out;
+    }
+
+    // 원래 data 저장
+    param->mode = eSIO_READ;    param->data = save;
+    if (!storage_io_run (path, param, &rd) || (rd.bytes != size)) {
+        printf ("%s : %s save error!\n", __func__, path);
+        goto out;
+    }
+
+    // pattern write (측정값)
+    sio_pattern (pattern, size);
+    crc = sio_crc32c (pattern, size);
+    param->mode = eSIO_WRITE;   param->data = pattern;
+    param->time_ms = time_ms;   param->series = series;
+    written = storage_io_run (path, param, result) && (result->bytes >= size);
+    param->time_ms = 0;         param->series = NULL;
+    if (!written) {
+        printf ("%s : %s write error!\n", __func__, path);
+        goto restore;
+    }
+
+    // read back
+    memset (pattern, 0, size);
+    param->mode = eSIO_READ;
+    if (storage_io_run (path, param, &rd) && (rd.bytes == size)) {
+        result->verify_mbps = rd.mbps;
+        result->crc         = sio_crc32c (pattern, size);
+        if (!(ret = (result->crc == crc)))
+            printf ("%s : %s verify error! (crc %08x != %08x)\n", __func__, path, result->crc, crc);
+    }
+    else
+        printf ("%s : %s read back error!\n", __func__, path);
+
+restore:
+    param->mode = eSIO_WRITE;   param->data = save;
+    if (!storage_io_run (path, param, &rd) || (rd.bytes != size)) {
+        printf ("%s : %s restore error! (offset %lld, size %lld)\n", __func__, path, param->offset, size);
+        ret = 0;
+    }
+out:
+    param->data    = NULL;
+    param->time_ms = time_ms;
+    param->series  = series;
+    free (save);
+    free (pattern);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// 영역 보존 io. param offset 부터 size 영역의 data를 저장한 뒤 param(random, mixed write 포함)을
+// 실행하고 원래 data를 복구함. result = param 실행 결과. return 1 = 실행 및 복구 성공
+//------------------------------------------------------------------------------
+int storage_io_preserve (const char *path, struct sio_param *param, struct sio_result *result)
+{
+    struct sio_param  p;
+    struct sio_result r;
+    char *save = NULL;
+    long long size;
+    int ret;
+
+    memset (result, 0, sizeof(struct sio_result));
+
+    memset (&p, 0, sizeof(p));
+    p.bs     = DEFAULT_SIO_BS;
+    p.qd     = DEFAULT_SIO_QD;
+    p.offset = param->offset & ~(long long)(SIO_ALIGN -1);
+    p.size   = (param->size + (param->offset - p.offset) + SIO_ALIGN -1) & ~(long long)(SIO_ALIGN -1);
+    if ((size = p.size) <= 0)
+        return 0;
+
+    if (posix_memalign ((void **)&save, SIO_ALIGN, size)) {
+        printf ("%s : memory alloc error! (%lld bytes)\n", __func__, size);
+        return 0;
+    }
+
+    // 원래 data 저장
+    p.mode = eSIO_READ;     p.data = save;
+    if (!storage_io_run (path, &p, &r) || (r.bytes != size)) {
+        printf ("%s : %s save error!\n", __func__, path);
+        free (save);
+        return 0;
+    }
+
+    ret = storage_io_run (path, param, result);
+
+    p.mode = eSIO_WRITE;
+    if (!storage_io_run (path, &p, &r) || (r.bytes != size)) {
+        printf ("%s : %s restore error! (offset %lld, size %lld)\n", __func__, path, p.offset, size);
+        ret = 0;
+    }
+    free (save);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// block size sweep. param offset 부터 size 영역을 1번 저장한 뒤 bs[] 마다 time_ms 동안
+// sequential read, pattern write 를 측정하고 read back (CRC32C) 후 원래 data를 복구함.
+// size는 bs[] 의 배수이어야 함. rd[], wr[] = block size별 MB/s. return 1 = 검증 성공
+//------------------------------------------------------------------------------
+int storage_io_sweep (const char *path, struct sio_param *param, const int *bs, int n,
+                        int *rd, int *wr)
+{
+    struct sio_param  p;
+    struct sio_result r;
+    char *save = NULL, *pattern = NULL;
+    unsigned int crc;
+    long long size;
+    int i, ret = 0;
+
+    memcpy (&p, param, sizeof(p));
+    p.random = p.mix = 0;
+    p.series = NULL;
+    p.offset &= ~(long long)(SIO_ALIGN -1);
+    p.size   &= ~(long long)(SIO_ALIGN -1);
+    if ((size = p.size) <= 0)
+        return 0;
+
+    memset (rd, 0, sizeof(int) * n);
+    memset (wr, 0, sizeof(int) * n);
+
+    if (posix_memalign ((void **)&save,    SIO_ALIGN, size) ||
+        posix_memalign ((void **)&pattern, SIO_ALIGN, size)) {
+        printf ("%s : memory alloc error! (%lld bytes)\n", __func__, size);
+        goto out;
+    }
+
+    // 원래 data 저장
+    p.mode = eSIO_READ;     p.data = save;      p.time_ms = 0;
+    if (!storage_io_run (path, &p, &r) || (r.bytes != size)) {
+        printf ("%s : %s save error!\n", __func__, path);
+        goto out;
+    }
+
+    // block size별 read (내부 buffer 사용)
+    p.data = NULL;          p.time_ms = param->time_ms;
+    for (i = 0; i < n; i++) {
+        p.bs  = bs[i];
+        rd[i] = storage_io_run (path, &p, &r) ? r.mbps : 0;
+    }
+
+    // block size별 pattern write
+    sio_pattern (pattern, size);
+    crc = sio_crc32c (pattern, size);
+    p.mode = eSIO_WRITE;    p.data = pattern;
+    for (i = 0; i < n; i++) {
+        p.bs  = bs[i];
+        if (!storage_io_run (path, &p, &r)) {
+            printf ("%s : %s write error! (bs %d)\n", __func__, path, bs[i]);
+            goto restore;
+        }
+        wr[i] = r.mbps;
+    }
+
+    // block size별 write는 time_ms로 종료되므로 span 전체에 pattern 기록 후 검증
+    p.bs = param->bs;       p.time_ms = 0;
+    if (!storage_io_run (path, &p, &r) || (r.bytes != size)) {
+        printf ("%s : %s write error!\n", __func__, path);
+        goto restore;
+    }
+
+    // read back
+    memset (pattern, 0, size);
+    p.mode = eSIO_READ;
+    if (storage_io_run (path, &p, &r) && (r.bytes == size)) {
+        if (!(ret = (sio_crc32c (pattern, size) == crc)))
+            printf ("%s : %s verify error!\n", __func__, path);
+    }
+    else
+        printf ("%s : %s read back error!\n", __func__, path);
+
+restore:
+    p.mode = eSIO_WRITE;    p.data = save;      p.bs = param->bs;   p.time_ms = 0;
+    if (!storage_io_run (path, &p, &r) || (r.bytes != size)) {
+        printf ("%s : %s restore error! (offset %lld, size %lld)\n", __func__, path, p.offset, size);
+        ret = 0;
+    }
+out:
+    free (save);
+    free (pattern);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+// multi-queue read. cpu core마다 thread를 고정(affinity)하여 각각의 fd, aio context로 실행하므로
+// blk-mq의 cpu별 submission queue가 모두 사용됨.
+//------------------------------------------------------------------------------
+struct sio_mq {
+    pthread_t thread;
+    int cpu, ret;
+    const char *path;
+    struct sio_param  param;
+    struct sio_result result;
+};
+
+static void *sio_mq_thread (void *arg)
+{
+    struct sio_mq *mq = (struct sio_mq *)arg;
+    cpu_set_t set;
+
+    CPU_ZERO (&set);
+    CPU_SET  (mq->cpu, &set);
+    pthread_setaffinity_np (pthread_self (), sizeof(set), &set);
+
+    mq->ret = storage_io_run (mq->path, &mq->param, &mq->result);
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+// threads(0 = online cpu 수) 개의 thread가 param size 만큼 서로 다른 영역을 동시에 read.
+// result = 전체 결과 (elapsed는 전체 thread 실행 시간). return 실행된 thread 수
+//------------------------------------------------------------------------------
+int storage_io_mq (const char *path, struct sio_param *param, int threads, struct sio_result *result)
+{
+    struct sio_mq mq [SIO_MQ_MAX];
+    long long start, lat_sum = 0, iops = 0;
+    int i, cnt = 0;
+
+    memset (result, 0, sizeof(struct sio_result));
+
+    if (threads <= 0)
+        threads = sysconf (_SC_NPROCESSORS_ONLN);
+    threads = (threads < 1) ? 1 : ((threads > SIO_MQ_MAX) ? SIO_MQ_MAX : threads);
+
+    start = now_us ();
+    for (i = 0; i < threads; i++) {
+        memset (&mq[i], 0, sizeof(struct sio_mq));
+        mq[i].cpu    = i;
+        mq[i].path   = path;
+        mq[i].param  = *param;
+        mq[i].param.mode   = eSIO_READ;
+        mq[i].param.offset = param->offset + param->size * i;
+        mq[i].param.data   = NULL;
+        mq[i].param.series = NULL;
+        if (pthread_create (&mq[i].thread, NULL, sio_mq_thread, &mq[i]))
+            break;
+    }
+    threads = i;
+
+    for (i = 0; i < threads; i++)
+        pthread_join (mq[i].thread, NULL);
+    result->elapsed_us = now_us () - start;
+
+    for (i = 0; i < threads; i++) {
+        struct sio_result *r = &mq[i].result;
+
+        if (!mq[i].ret)
+            continue;
+        if (!cnt || (r->lat_min < result->lat_min)) result->lat_min = r->lat_min;
+        if (r->lat_max > result->lat_max)           result->lat_max = r->lat_max;
+
+        result->bytes += r->bytes;
+        result->direct = r->direct;
+        result->aio    = r->aio;
+        // thread별 iops는 동시에 실행되므로 합계가 전체 iops
+        iops    += r->iops;
+        lat_sum += (long long)r->lat_avg * r->iops;
+        cnt++;
+    }
+    if (result->elapsed_us > 0)
+        result->mbps = result->bytes / result->elapsed_us;
+    if (iops) {
+        result->iops    = iops;
+        result->lat_avg = lat_sum / iops;
+    }
+    return cnt;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,148 @@
+//------------------------------------------------------------------------------
+/**
+ * @file storage_io.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Device Test library for ODROID-JIG. (storage io engine)
+ * @version 0.2
+ * @date 2023-10-12
+ *
+ * @package apt install iperf3, nmap, ethtool, usbutils, alsa-utils
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __STORAGE_IO_H__
+#define __STORAGE_IO_H__
+
+//------------------------------------------------------------------------------
+// O_DIRECT + linux native aio (pread/pwrite fallback)
+//------------------------------------------------------------------------------
+// buffer, offset, block size align (logical block size 이상)
+#define SIO_ALIGN           4096
+#define SIO_QD_MAX          64
+
+// default 1MB block, 16MB total, queue depth 4
+#define DEFAULT_SIO_BS      (1024 * 1024)
+#define DEFAULT_SIO_SIZE    (16 * 1024 * 1024)
+#define DEFAULT_SIO_QD      4
+
+// storage_io_mq thread (cpu core) max
+#define SIO_MQ_MAX          16
+
+enum {
+    eSIO_READ = 0,
+    eSIO_WRITE,
+    // read/write 혼합 (param mix = write %)
+    eSIO_MIXED,
+};
+
+struct sio_param {
+    // eSIO_READ, eSIO_WRITE, eSIO_MIXED
+    int mode;
+    // block size (bytes, SIO_ALIGN 배수)
+    int bs;
+    // queue depth (1 = pread/pwrite)
+    int qd;
+    // start offset, total size (bytes). random 인 경우 size는 offset 범위.
+    long long offset;
+    long long size;
+
+    // 1 = random offset (bs 단위)
+    int random;
+    // eSIO_MIXED write 비율 (%)
+    int mix;
+    // 0 = size 만큼 실행, 그 외 time_ms 동안 실행 (sequential은 offset부터 반복)
+    int time_ms;
+
+    // io data buffer (SIO_ALIGN align, size bytes). NULL = 내부 buffer 사용.
+    // sequential(random = 0)인 경우만 사용 가능.
+    char *data;
+
+    // window 단위 throughput 기록 (NULL = 사용 안함)
+    struct sio_series *series;
+
+    // 1이 되면 새로운 io를 시작하지 않고 종료 (다른 thread에서 설정, NULL = 사용 안함)
+    volatile int *cancel;
+};
+
+//------------------------------------------------------------------------------
+// latency histogram (HDR style log-linear bucket, us)
+// 2^SIO_HIST_SUB_BITS 보다 작은 값은 1us 단위, 큰 값은 2배 구간마다 16 bucket. (오차 6.25% 이하)
+//------------------------------------------------------------------------------
+#define SIO_HIST_SUB_BITS   5
+#define SIO_HIST_SIZE       (32 * 16)
+
+struct sio_hist {
+    long long count[SIO_HIST_SIZE];
+    long long total;
+};
+
+//------------------------------------------------------------------------------
+// throughput time series. window(default 100ms) 단위 MB/s를 ring buffer에 기록.
+//------------------------------------------------------------------------------
+#define SIO_SERIES_MAX      1200
+#define SIO_SERIES_WINDOW   100
+// drop 판정 : 처음 SIO_SERIES_BASE window 평균 대비 SIO_SERIES_DROP(%) 이하
+#define SIO_SERIES_BASE     10
+#define SIO_SERIES_DROP     70
+
+struct sio_series {
+    // window (ms), drop 판정 (%)
+    int window_ms, drop_pct;
+
+    // ring buffer (MB/s, 최근 SIO_SERIES_MAX window)
+    int mbps[SIO_SERIES_MAX];
+    int head, count;
+
+    // 전체 window 결과 (MB/s)
+    int windows, min, max, mean, last, base;
+    long long sum;
+    // throughput이 떨어진 시점 (ms), -1 = 없음
+    int drop_ms;
+};
+
+struct sio_result {
+    // MB/s (1MB = 1000000 bytes, dd와 같은 단위)
+    int mbps;
+    int iops;
+    // io latency (us)
+    int lat_avg, lat_min, lat_max;
+    // latency percentile (us)
+    int lat_p50, lat_p99, lat_p999;
+
+    long long bytes;
+    long long elapsed_us;
+
+    // 0 = O_DIRECT를 지원하지 않는 file system (page cache 사용)
+    int direct;
+    // 1 = native aio, 0 = pread/pwrite
+    int aio;
+
+    // storage_io_verify : read back MB/s, read back data CRC32C
+    int verify_mbps;
+    unsigned int crc;
+};
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+extern void sio_hist_add      (struct sio_hist *hist, long long us);
+extern int  sio_hist_pct      (struct sio_hist *hist, int pct_x100);
+extern unsigned int sio_crc32c(const void *data, long long size);
+extern void sio_series_init   (struct sio_series *series, int window_ms, int drop_pct);
+extern int  sio_series_get    (struct sio_series *series, int n);
+extern void sio_param_init    (struct sio_param *param, int mode);
+extern int  storage_io_run    (const char *path, struct sio_param *param, struct sio_result *result);
+extern int  storage_io_verify (const char *path, struct sio_param *param, struct sio_result *result);
+extern int  storage_io_preserve (const char *path, struct sio_param *param, struct sio_result *result);
+extern int  storage_io_sweep  (const char *path, struct sio_param *param, const int *bs, int n,
+                                int *rd, int *wr);
+extern long long storage_io_size (const char *path);
+extern int  storage_io_mq     (const char *path, struct sio_param *param, int threads,
+                                struct sio_result *result);
+
+//------------------------------------------------------------------------------
+#endif  // __STORAGE_IO_H__
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
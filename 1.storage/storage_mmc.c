@@ -0,0 +1,182 @@
+//------------------------------------------------------------------------------
+/**
+ * @file storage_mmc.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Device Test library for ODROID-JIG. (eMMC/uSD bus mode check)
+ * @version 0.2
+ * @date 2023-10-12
+ *
+ * @package apt install iperf3, nmap, ethtool, usbutils, alsa-utils
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <linux/mmc/ioctl.h>
+
+//------------------------------------------------------------------------------
+#include "../lib_dev_check.h"
+#include "storage_mmc.h"
+
+//------------------------------------------------------------------------------
+// linux/mmc/core.h (kernel header) response type
+//------------------------------------------------------------------------------
+#define MMC_RSP_PRESENT     (1 << 0)
+#define MMC_RSP_CRC         (1 << 2)
+#define MMC_RSP_OPCODE      (1 << 4)
+#define MMC_CMD_ADTC        (1 << 5)
+#define MMC_RSP_SPI_S1      (1 << 7)
+
+#define MMC_RSP_R1          (MMC_RSP_PRESENT | MMC_RSP_CRC | MMC_RSP_OPCODE)
+#define MMC_RSP_SPI_R1      (MMC_RSP_SPI_S1)
+
+#define MMC_SEND_EXT_CSD    8
+
+#define DEBUGFS_MMC_PATH    "/sys/kernel/debug"
+
+//------------------------------------------------------------------------------
+// /dev/mmcblk0 -> mmc host name (mmc0), card type (MMC, SD)
+//------------------------------------------------------------------------------
+static int mmc_host_name (const char *path, char *host, int *sd)
+{
+    char fname [STR_PATH_LENGTH *2 +1], real [PATH_MAX], type [16], *ptr;
+    const char *name = strrchr (path, '/');
+    FILE *fp;
+
+    if (name == NULL)
+        return 0;
+
+    // /sys/devices/platform/fe310000.mmc/mmc_host/mmc0/mmc0:0001
+    snprintf (fname, sizeof(fname), "/sys/class/block/%s/device", name +1);
+    if ((realpath (fname, real) == NULL) || ((ptr = strrchr (real, '/')) == NULL))
+        return 0;
+    if (sscanf (ptr +1, "%15[^:]", host) != 1)
+        return 0;
+
+    memset (type, 0, sizeof(type));
+    snprintf (fname, sizeof(fname), "/sys/class/block/%s/device/type", name +1);
+    if ((fp = fopen (fname, "r")) != NULL) {
+        fgets  (type, sizeof(type), fp);
+        fclose (fp);
+    }
+    *sd = !strncmp (type, "SD", 2);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// debugfs ios
+//  clock:          200000000 Hz
+//  actual clock:   200000000 Hz
+//  bus width:      3 (8 bits)
+//  timing spec:    10 (mmc HS400 enhanced strobe)
+//------------------------------------------------------------------------------
+static int mmc_ios (const char *host, struct mmc_link *link)
+{
+    char fname [STR_PATH_LENGTH +1], line [STR_PATH_LENGTH +1], *ptr;
+    FILE *fp;
+    int cnt = 0;
+
+    snprintf (fname, sizeof(fname), "%s/%s/ios", DEBUGFS_MMC_PATH, host);
+    if ((fp = fopen (fname, "r")) == NULL) {
+        printf ("%s : %s open error! (debugfs mount?)\n", __func__, fname);
+        return 0;
+    }
+
+    while (fgets (line, sizeof(line), fp) != NULL) {
+        if ((ptr = strchr (line, ':')) == NULL)
+            continue;
+        *ptr++ = 0;
+
+        if (!strcmp (line, "clock")) {
+            link->clock = atoi (ptr);
+            cnt++;
+        }
+        else if (!strcmp (line, "actual clock"))
+            link->actual_clock = atoi (ptr);
+        else if (!strcmp (line, "bus width")) {
+            if ((ptr = strchr (ptr, '(')) != NULL) {
+                link->width = atoi (ptr +1);
+                cnt++;
+            }
+        }
+        else if (!strcmp (line, "timing spec")) {
+            link->timing = atoi (ptr);
+            if (sscanf (ptr, "%*d (%31[^)]", link->timing_str) != 1)
+                link->timing_str[0] = 0;
+            cnt++;
+        }
+    }
+    fclose (fp);
+
+    // 이전 kernel은 actual clock 항목이 없음
+    if (!link->actual_clock)
+        link->actual_clock = link->clock;
+
+    return (cnt == 3) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// eMMC EXT_CSD (CMD8)
+//------------------------------------------------------------------------------
+static int mmc_ext_csd (const char *path, unsigned char *ext_csd)
+{
+    struct mmc_ioc_cmd cmd;
+    int fd, ret;
+
+    if ((fd = open (path, O_RDONLY | O_CLOEXEC)) < 0)
+        return 0;
+
+    memset (&cmd, 0, sizeof(cmd));
+    cmd.opcode  = MMC_SEND_EXT_CSD;
+    cmd.flags   = MMC_RSP_SPI_R1 | MMC_RSP_R1 | MMC_CMD_ADTC;
+    cmd.blksz   = EXT_CSD_SIZE;
+    cmd.blocks  = 1;
+    mmc_ioc_cmd_set_data (cmd, ext_csd);
+
+    if ((ret = ioctl (fd, MMC_IOC_CMD, &cmd)) < 0)
+        printf ("%s : %s MMC_IOC_CMD error! (%s)\n", __func__, path, strerror (errno));
+
+    close (fd);
+    return (ret < 0) ? 0 : 1;
+}
+
+//------------------------------------------------------------------------------
+// mmc block device(/dev/mmcblkN)의 bus mode. return 1 = success
+//------------------------------------------------------------------------------
+int storage_mmc_link (const char *path, struct mmc_link *link)
+{
+    unsigned char ext_csd [EXT_CSD_SIZE];
+    char host [16];
+
+    memset (link, 0, sizeof(struct mmc_link));
+    link->hs_timing = link->bus_width = link->rev = link->card_type = -1;
+
+    if (!mmc_host_name (path, host, &link->sd) || !mmc_ios (host, link))
+        return 0;
+
+    if (link->sd)
+        return 1;
+
+    // EXT_CSD를 읽을 수 없는 경우 (ioctl EPERM 등) host ios만 사용. (hs_timing = -1)
+    if (!mmc_ext_csd (path, ext_csd))
+        return 1;
+
+    link->hs_timing = ext_csd [EXT_CSD_HS_TIMING] & 0x0F;
+    link->bus_width = ext_csd [EXT_CSD_BUS_WIDTH];
+    link->rev       = ext_csd [EXT_CSD_REV];
+    link->card_type = ext_csd [EXT_CSD_CARD_TYPE];
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
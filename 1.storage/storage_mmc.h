@@ -0,0 +1,62 @@
+//------------------------------------------------------------------------------
+/**
+ * @file storage_mmc.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Device Test library for ODROID-JIG. (eMMC/uSD bus mode check)
+ * @version 0.2
+ * @date 2023-10-12
+ *
+ * @package apt install iperf3, nmap, ethtool, usbutils, alsa-utils
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __STORAGE_MMC_H__
+#define __STORAGE_MMC_H__
+
+//------------------------------------------------------------------------------
+// mmc host timing spec (/sys/kernel/debug/mmcX/ios, kernel MMC_TIMING_xxx)
+//------------------------------------------------------------------------------
+enum {
+    eMMC_TIMING_LEGACY = 0,
+    eMMC_TIMING_MMC_HS,
+    eMMC_TIMING_SD_HS,
+    eMMC_TIMING_UHS_SDR12,
+    eMMC_TIMING_UHS_SDR25,
+    eMMC_TIMING_UHS_SDR50,
+    eMMC_TIMING_UHS_SDR104,
+    eMMC_TIMING_UHS_DDR50,
+    eMMC_TIMING_MMC_DDR52,
+    eMMC_TIMING_MMC_HS200,
+    eMMC_TIMING_MMC_HS400,
+};
+
+// EXT_CSD byte offset
+#define EXT_CSD_SIZE            512
+#define EXT_CSD_BUS_WIDTH       183
+#define EXT_CSD_HS_TIMING       185
+#define EXT_CSD_REV             192
+#define EXT_CSD_CARD_TYPE       196
+
+struct mmc_link {
+    // 1 = SD card (EXT_CSD 없음)
+    int sd;
+    // host ios : timing spec, bus width (bits), clock (Hz)
+    int timing, width;
+    int clock, actual_clock;
+    char timing_str [32];
+
+    // eMMC EXT_CSD (SD card, 읽기 실패 = -1)
+    int hs_timing, bus_width, rev, card_type;
+};
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+extern int  storage_mmc_link    (const char *path, struct mmc_link *link);
+
+//------------------------------------------------------------------------------
+#endif  // __STORAGE_MMC_H__
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,189 @@
+//------------------------------------------------------------------------------
+/**
+ * @file storage_scan.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Device Test library for ODROID-JIG. (block device discovery)
+ * @version 0.2
+ * @date 2023-10-12
+ *
+ * @package apt install iperf3, nmap, ethtool, usbutils, alsa-utils
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <pthread.h>
+
+//------------------------------------------------------------------------------
+#include "../lib_dev_check.h"
+#include "storage_scan.h"
+
+//------------------------------------------------------------------------------
+#define SYS_BLOCK_PATH      "/sys/block"
+
+// storage_scan 결과. storage_scan() 호출시에만 변경됨.
+static struct blk_info BlkInfo [BLK_SCAN_MAX];
+static int BlkCount = 0;
+static pthread_mutex_t BlkMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *BlkTypeStr [eBLK_END] = {
+    "unknown", "eMMC", "SD", "SATA", "NVMe", "USB"
+};
+
+//------------------------------------------------------------------------------
+const char *storage_scan_type (int type)
+{
+    return ((type < 0) || (type >= eBLK_END)) ? BlkTypeStr[eBLK_UNKNOWN] : BlkTypeStr[type];
+}
+
+//------------------------------------------------------------------------------
+// /sys/block/<name>/<attr> (첫 line)
+//------------------------------------------------------------------------------
+static int blk_attr (const char *name, const char *attr, char *value, int size)
+{
+    char fname [STR_PATH_LENGTH *2 +1];
+    FILE *fp;
+
+    memset (value, 0, size);
+    snprintf (fname, sizeof(fname), "%s/%s/%s", SYS_BLOCK_PATH, name, attr);
+    if ((fp = fopen (fname, "r")) == NULL)
+        return 0;
+
+    fgets  (value, size, fp);
+    fclose (fp);
+    value[strcspn (value, "\r\n")] = 0;
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static int blk_attr_int (const char *name, const char *attr)
+{
+    char value [32];
+
+    return blk_attr (name, attr, value, sizeof(value)) ? atoi (value) : 0;
+}
+
+//------------------------------------------------------------------------------
+// parent subsystem(controller path)으로 분류.
+// /sys/devices/platform/fe310000.mmc/mmc_host/mmc0/mmc0:0001/block/mmcblk0 (device/type = MMC, SD)
+// /sys/devices/pci0000:00/.../nvme/nvme0/nvme0n1
+// /sys/devices/platform/.../usb2/2-1/2-1:1.0/host0/target0:0:0/0:0:0:0/block/sda
+// /sys/devices/pci0000:00/.../ata1/host0/target0:0:0/0:0:0:0/block/sda
+//------------------------------------------------------------------------------
+static int blk_type (const char *name)
+{
+    char fname [STR_PATH_LENGTH +1], real [PATH_MAX], type [16], *ptr;
+
+    snprintf (fname, sizeof(fname), "%s/%s", SYS_BLOCK_PATH, name);
+    if (realpath (fname, real) == NULL)
+        return eBLK_UNKNOWN;
+
+    // loop, ram, zram ...
+    if (strstr (real, "/devices/virtual/"))
+        return eBLK_UNKNOWN;
+
+    if (((ptr = strstr (real, "/usb")) != NULL) && isdigit (ptr[4]))
+        return eBLK_USB;
+
+    if (strstr (real, "/mmc_host/")) {
+        // mmcblk0boot0, mmcblk0boot1 (eMMC hw partition)
+        if (strstr (name, "boot"))
+            return eBLK_UNKNOWN;
+        blk_attr (name, "device/type", type, sizeof(type));
+        if (!strcmp (type, "MMC"))  return eBLK_EMMC;
+        if (!strcmp (type, "SD"))   return eBLK_SD;
+        return eBLK_UNKNOWN;
+    }
+    if (strstr (real, "/nvme/") || strstr (real, "/nvme-subsystem/"))
+        return eBLK_NVME;
+
+    if (strstr (real, "/ata") && strncmp (name, "sr", 2))
+        return eBLK_SATA;
+
+    return eBLK_UNKNOWN;
+}
+
+//------------------------------------------------------------------------------
+static int blk_compare (const void *a, const void *b)
+{
+    return strcmp (((const struct blk_info *)a)->name, ((const struct blk_info *)b)->name);
+}
+
+//------------------------------------------------------------------------------
+// /sys/block scan. return 분류된 device 수
+//------------------------------------------------------------------------------
+int storage_scan (void)
+{
+    struct blk_info list [BLK_SCAN_MAX], *info;
+    struct dirent *d;
+    DIR *dir;
+    char value [32];
+    int cnt = 0, type, i;
+
+    if ((dir = opendir (SYS_BLOCK_PATH)) == NULL)
+        return 0;
+
+    while (((d = readdir (dir)) != NULL) && (cnt < BLK_SCAN_MAX)) {
+        if ((d->d_name[0] == '.') || (strlen (d->d_name) >= sizeof(list[0].name)))
+            continue;
+        if ((type = blk_type (d->d_name)) == eBLK_UNKNOWN)
+            continue;
+
+        info = &list[cnt++];
+        memset (info, 0, sizeof(struct blk_info));
+        strcpy (info->name, d->d_name);
+        info->type        = type;
+        info->queue_depth = blk_attr_int (d->d_name, "queue/nr_requests");
+        info->lbs         = blk_attr_int (d->d_name, "queue/logical_block_size");
+        info->rotational  = blk_attr_int (d->d_name, "queue/rotational");
+        info->removable   = blk_attr_int (d->d_name, "removable");
+        if (blk_attr (d->d_name, "size", value, sizeof(value)))
+            info->size = atoll (value) * 512;
+    }
+    closedir (dir);
+
+    // mmcblk0, mmcblk1 ... 순서
+    qsort (list, cnt, sizeof(struct blk_info), blk_compare);
+
+    pthread_mutex_lock (&BlkMutex);
+    memcpy (BlkInfo, list, sizeof(struct blk_info) * cnt);
+    BlkCount = cnt;
+    pthread_mutex_unlock (&BlkMutex);
+
+    for (i = 0; i < cnt; i++)
+        printf ("%s : /dev/%s %s, qd %d, lbs %d, %s, %lld MB\n",
+            __func__, list[i].name, storage_scan_type (list[i].type), list[i].queue_depth,
+            list[i].lbs, list[i].rotational ? "rotational" : "non-rotational",
+            list[i].size / 1024 / 1024);
+
+    return cnt;
+}
+
+//------------------------------------------------------------------------------
+// index 번째 type device. return 0 = 없음
+//------------------------------------------------------------------------------
+int storage_scan_find (int type, int index, struct blk_info *info)
+{
+    int i, found = 0;
+
+    pthread_mutex_lock (&BlkMutex);
+    for (i = 0; i < BlkCount; i++) {
+        if ((BlkInfo[i].type == type) && (index-- == 0)) {
+            memcpy (info, &BlkInfo[i], sizeof(struct blk_info));
+            found = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock (&BlkMutex);
+    return found;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
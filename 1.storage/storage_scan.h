@@ -0,0 +1,56 @@
+//------------------------------------------------------------------------------
+/**
+ * @file storage_scan.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Device Test library for ODROID-JIG. (block device discovery)
+ * @version 0.2
+ * @date 2023-10-12
+ *
+ * @package apt install iperf3, nmap, ethtool, usbutils, alsa-utils
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __STORAGE_SCAN_H__
+#define __STORAGE_SCAN_H__
+
+//------------------------------------------------------------------------------
+// /sys/block scan 결과 (parent subsystem, controller path로 분류)
+//------------------------------------------------------------------------------
+#define BLK_SCAN_MAX        32
+
+enum {
+    eBLK_UNKNOWN = 0,
+    eBLK_EMMC,
+    eBLK_SD,
+    eBLK_SATA,
+    eBLK_NVME,
+    eBLK_USB,
+    eBLK_END
+};
+
+struct blk_info {
+    // block device name (mmcblk0, sda, nvme0n1 ...)
+    char name [32];
+    int  type;
+
+    // queue depth (queue/nr_requests), logical block size (bytes), 1 = hdd
+    int  queue_depth, lbs, rotational;
+    // 1 = removable media
+    int  removable;
+    // device size (bytes)
+    long long size;
+};
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+extern int          storage_scan        (void);
+extern int          storage_scan_find   (int type, int index, struct blk_info *info);
+extern const char  *storage_scan_type   (int type);
+
+//------------------------------------------------------------------------------
+#endif  // __STORAGE_SCAN_H__
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -31,10 +31,13 @@
 #include <getopt.h>
 #include <pthread.h>
 #include <sys/sysinfo.h>
+#include <dirent.h>
 
 //------------------------------------------------------------------------------
 #include "../lib_dev_check.h"
 #include "usb.h"
+#include "usb_uevent.h"
+#include "../1.storage/storage_io.h"
 
 //------------------------------------------------------------------------------
 struct device_usb {
@@ -77,9 +80,100 @@ struct device_usb DeviceUSB [eUSB_END] = {
     { "/sys/bus/usb/devices/1-1", DEFAULT_USB20_R, DEFAULT_USB20_W, DEFAULT_USB20_L, 0 },
 };
 
-// USB Read / Write (16 Mbytes, 1 block count)
-#define USB_R_CHECK "dd of=/dev/null bs=16M count=1 iflag=nocache,dsync oflag=nocache,dsync if=/dev/"
-#define USB_W_CHECK "dd if=/dev/zero bs=16M count=1 iflag=nocache,dsync oflag=nocache,dsync of=/dev/"
+// port에 연결된 block device name cache. uevent (usb, scsi, block) 수신시 무효화.
+// uevent listener가 실행되지 않는 경우 (netlink error) cache를 사용하지 않음.
+struct usb_blk_cache {
+    // 저장시 UsbBlkGen 값 (0 = 없음)
+    int gen;
+    // block device name (없으면 "")
+    char name[32];
+};
+
+static struct usb_blk_cache UsbBlkCache [eUSB_END];
+static int UsbBlkGen = 1;
+static pthread_mutex_t UsbBlkMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// hotplug auto-test. port에 usb device가 연결(add uevent)되면 block device 준비까지의 시간을
+// 측정하고 link speed, read 속도를 확인하여 port별 queue에 저장함. ('E'로 읽음)
+struct usb_hotplug_result {
+    // usb device add -> block device add (ms), link speed, read (MB/s), status
+    int enum_ms, speed, mbps, status;
+};
+
+#define USB_HOTPLUG_QUEUE   8
+
+struct usb_hotplug {
+    // usb device add uevent 시간 (ms, 0 = 없음)
+    long long plug_ms;
+    // 결과 queue (ring buffer)
+    struct usb_hotplug_result q [USB_HOTPLUG_QUEUE];
+    int head, count;
+};
+
+static struct usb_hotplug UsbHotplug [eUSB_END];
+static pthread_mutex_t UsbHotplugMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// root hub(bus)별 r/w 직렬화. lane 경로의 check (R/W/5/6/B)와 hotplug test thread가 같이 사용.
+// (index = root hub number % USB_HUB_LOCK, 겹치는 경우 직렬화만 늘어남)
+#define USB_HUB_LOCK    16
+
+static pthread_mutex_t UsbHubMutex [USB_HUB_LOCK];
+
+// usb device add -> block device 준비 시간 max (ms, jig-usb.cfg "hotplug" line)
+int UsbEnumMax = 3000;
+
+// 모든 port 동시 측정 setting (jig-usb.cfg "all" line)
+struct usb_all {
+    // read/write 합계 min (MB/s), port별 min (r_min/w_min 대비 %), 측정 시간 (ms)
+    int rd_min, wr_min, port_pct, time_ms;
+};
+
+struct usb_all UsbALL = { 100, 40, 50, 3000 };
+
+// 동시 측정시 port별 r/w 영역 (bytes, time_ms 동안 반복)
+#define USB_ALL_SPAN    (64 * 1024 * 1024)
+
+// block size sweep setting (jig-usb.cfg "sweep" line)
+struct usb_sweep_cfg {
+    // block size별 측정 시간 (ms), r/w 영역 (MB), queue depth
+    int time_ms, span_mb, qd;
+};
+
+struct usb_sweep_cfg UsbSWEEP = { 150, 32, DEFAULT_SIO_QD };
+
+// sweep 판정 block size (jig-usb.cfg "sweep_min" line, bs_kb = 0 사용 안함)
+struct usb_sweep_min {
+    // block size (KB), read/write min (rd_speed/wr_speed 대비 %)
+    int bs_kb, rd_pct, wr_pct;
+};
+
+#define USB_SWEEP_MIN_MAX   4
+
+struct usb_sweep_min UsbSweepMin [USB_SWEEP_MIN_MAX] = {
+    {  64, 50, 50 },
+    { 512, 80, 80 },
+    {   0,  0,  0 },
+    {   0,  0,  0 },
+};
+
+// sweep 결과 (4K ~ 16M, 2배 단위). 'K'로 1 point씩 읽음.
+#define USB_SWEEP_BS        4096
+#define USB_SWEEP_POINTS    13
+
+struct usb_sweep {
+    int rd [USB_SWEEP_POINTS], wr [USB_SWEEP_POINTS];
+    int count, pos;
+};
+
+static struct usb_sweep UsbSweep [eUSB_END];
+static pthread_mutex_t UsbSweepMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// 'A', 'C'(모든 port 동시 측정) 중에는 다른 usb check를 실행하지 않음.
+static pthread_rwlock_t UsbLock = PTHREAD_RWLOCK_INITIALIZER;
+
+// port path 아래 block directory 검색 깊이
+// (8-1/8-1:1.0/host0/target0:0:0/0:0:0:0/block/sda)
+#define USB_BLK_DEPTH   8
 
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
@@ -90,9 +184,9 @@ static int usb_speed (const char *path)
 
     if (access (path, R_OK) == 0) {
         memset  (cmd, 0x00, sizeof(cmd));
+        memset  (rdata, 0x00, sizeof(rdata));
         sprintf (cmd, "%s/speed", path);
         if ((fp = fopen (cmd, "r")) != NULL) {
-            memset (rdata, 0, sizeof(rdata));
             fgets  (rdata, sizeof(rdata), fp);
             fclose (fp);
         }
@@ -102,64 +196,539 @@ static int usb_speed (const char *path)
 }
 
 //------------------------------------------------------------------------------
-static int usb_rw (const char *path, const char *check_cmd)
+// sysfs directory tree에서 "block" directory의 첫번째 device name 검색.
+// symlink (subsystem, driver, port ...)는 따라가지 않음. return 0 = 없음
+//------------------------------------------------------------------------------
+static int usb_blk_find (const char *path, char *name, int depth)
 {
-    FILE *fp;
-    char cmd[STR_PATH_LENGTH], rdata[STR_PATH_LENGTH], *ptr;
-
-    memset  (cmd, 0x00, sizeof(cmd));
-    sprintf (cmd, "find %s/ -name sd* 2>&1", path);
-
-    if ((fp = popen (cmd, "r")) != NULL) {
-        memset (rdata, 0x00, sizeof(cmd));
-        // 1 line read
-        fgets (rdata, sizeof(rdata), fp);
-        fclose (fp);
-        // find string "sd"
-        if ((ptr = strstr (rdata, "sd")) != NULL) {
-            memset  (cmd, 0, sizeof (cmd));
-            // 0x00 -> 0x20 (space)
-            ptr[strlen(ptr)-1] = ' ';
-            sprintf (cmd, "%s%s 2>&1", check_cmd, ptr);
-
-            if ((fp = popen(cmd, "r")) != NULL) {
-                while (1) {
-                    memset (rdata, 0, sizeof (rdata));
-                    if ((fgets (rdata, sizeof (rdata), fp)) == NULL)
-                        break;
-                    if ((ptr = strstr (rdata, " MB/s")) != NULL) {
-                        while (*ptr != ',') ptr--;
-                        return atoi (ptr+1);
-                    }
+    char sub [PATH_MAX];
+    struct dirent *d;
+    DIR *dir;
+    int found = 0;
+
+    if ((dir = opendir (path)) == NULL)
+        return 0;
+
+    while (!found && ((d = readdir (dir)) != NULL)) {
+        if ((d->d_type != DT_DIR) || (d->d_name[0] == '.'))
+            continue;
+
+        snprintf (sub, sizeof(sub), "%s/%s", path, d->d_name);
+        if (!strcmp (d->d_name, "block")) {
+            DIR *blk;
+            struct dirent *b;
+
+            if ((blk = opendir (sub)) == NULL)
+                continue;
+            while ((b = readdir (blk)) != NULL) {
+                if ((b->d_type == DT_DIR) && (b->d_name[0] != '.')) {
+                    strncpy (name, b->d_name, 31);
+                    found = 1;
+                    break;
                 }
-                pclose (fp);
             }
+            closedir (blk);
         }
+        else if (depth > 1)
+            found = usb_blk_find (sub, name, depth -1);
     }
-    return 0;
+    closedir (dir);
+    return found;
+}
+
+//------------------------------------------------------------------------------
+// usb port에 연결된 storage의 block device name. (sda, sdb ...) return 0 = 없음
+//------------------------------------------------------------------------------
+static int usb_blk_name (int id, char *name)
+{
+    struct usb_blk_cache *cache = &UsbBlkCache[id];
+    int gen, found;
+
+    memset (name, 0, 32);
+
+    pthread_mutex_lock (&UsbBlkMutex);
+    gen = UsbBlkGen;
+    if (usb_uevent_running () && (cache->gen == gen)) {
+        strcpy (name, cache->name);
+        pthread_mutex_unlock (&UsbBlkMutex);
+        return name[0] ? 1 : 0;
+    }
+    pthread_mutex_unlock (&UsbBlkMutex);
+
+    found = usb_blk_find (DeviceUSB[id].path, name, USB_BLK_DEPTH);
+
+    // 검색 중 uevent가 수신된 경우 저장하지 않음
+    pthread_mutex_lock (&UsbBlkMutex);
+    if (gen == UsbBlkGen) {
+        cache->gen = gen;
+        strcpy (cache->name, name);
+    }
+    pthread_mutex_unlock (&UsbBlkMutex);
+    return found;
+}
+
+//------------------------------------------------------------------------------
+// 비파괴 write 검증 (storage_verify_write). return MB/s
+//------------------------------------------------------------------------------
+static int usb_write (int id)
+{
+    char name[32], node[64];
+
+    if (!usb_blk_name (id, name))
+        return 0;
+
+    sprintf (node, "/dev/%s", name);
+    return storage_verify_write (node, -1);
+}
+
+//------------------------------------------------------------------------------
+// Sustained read / write (storage_sustain). return status, value = 평균 MB/s
+//------------------------------------------------------------------------------
+static int usb_sustain (int id, int mode, int min, int *value)
+{
+    char name[32], node[64];
+
+    if (!usb_blk_name (id, name))
+        return 0;
+
+    sprintf (node, "/dev/%s", name);
+    return storage_sustain (node, mode, min, -1, value);
+}
+
+//------------------------------------------------------------------------------
+// port가 연결된 root hub의 r/w lock
+//------------------------------------------------------------------------------
+static void usb_hub_lock (int id)
+{
+    pthread_mutex_lock   (&UsbHubMutex[usb_root_hub (id) % USB_HUB_LOCK]);
+}
+
+static void usb_hub_unlock (int id)
+{
+    pthread_mutex_unlock (&UsbHubMutex[usb_root_hub (id) % USB_HUB_LOCK]);
+}
+
+//------------------------------------------------------------------------------
+// USB Read (16 Mbytes, O_DIRECT). return MB/s
+//------------------------------------------------------------------------------
+static int usb_rw (int id)
+{
+    struct sio_param  param;
+    struct sio_result result;
+    char name[32], node[64];
+
+    if (!usb_blk_name (id, name))
+        return 0;
+
+    sprintf (node, "/dev/%s", name);
+    sio_param_init (&param, eSIO_READ);
+    if (!storage_io_run (node, &param, &result))
+        return 0;
+
+    return result.mbps;
+}
+
+//------------------------------------------------------------------------------
+// hotplug test thread. block device 준비 후 link speed, read 속도를 측정하여 queue에 저장.
+//------------------------------------------------------------------------------
+struct usb_hotplug_job {
+    int id, enum_ms;
+};
+
+static void *usb_hotplug_thread (void *arg)
+{
+    struct usb_hotplug_job *job = (struct usb_hotplug_job *)arg;
+    struct usb_hotplug *hp = &UsbHotplug[job->id];
+    struct usb_hotplug_result r;
+    char name[32], node[64];
+    int i;
+
+    memset (&r, 0, sizeof(r));
+    r.enum_ms = job->enum_ms;
+
+    // devtmpfs node 생성 대기 (max 1초)
+    if (usb_blk_name (job->id, name)) {
+        sprintf (node, "/dev/%s", name);
+        for (i = 0; (i < 100) && (access (node, R_OK) != 0); i++)
+            usleep (10000);
+    }
+    // 같은 root hub에서 실행중인 check와 겹치지 않도록 hub lock
+    pthread_rwlock_rdlock (&UsbLock);
+    usb_hub_lock (job->id);
+    r.speed  = usb_speed (DeviceUSB[job->id].path);
+    r.mbps   = usb_rw    (job->id);
+    usb_hub_unlock (job->id);
+    pthread_rwlock_unlock (&UsbLock);
+    r.status = (r.enum_ms <= UsbEnumMax) && (r.speed == DeviceUSB[job->id].speed) &&
+                (r.mbps >= DeviceUSB[job->id].r_min);
+
+    printf ("%s : %s enum %d ms, link %d, read %d MB/s (%s)\n", __func__,
+        DeviceUSB[job->id].path, r.enum_ms, r.speed, r.mbps, r.status ? "pass" : "fail");
+
+    pthread_mutex_lock (&UsbHotplugMutex);
+    // queue가 가득 찬 경우 가장 오래된 결과를 버림
+    if (hp->count == USB_HOTPLUG_QUEUE) {
+        hp->head = (hp->head +1) % USB_HOTPLUG_QUEUE;
+        hp->count--;
+    }
+    hp->q[(hp->head + hp->count) % USB_HOTPLUG_QUEUE] = r;
+    hp->count++;
+    pthread_mutex_unlock (&UsbHotplugMutex);
+
+    free (job);
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+// uevent devpath가 port의 device 이거나 (basename 일치) port 아래의 device 인지 확인.
+// return port id, -1 = 없음
+//------------------------------------------------------------------------------
+static int usb_hotplug_port (const char *devpath, int sub)
+{
+    char key [STR_PATH_LENGTH +4];
+    const char *port, *ptr;
+    int i;
+
+    for (i = 0; i < eUSB_END; i++) {
+        if ((port = strrchr (DeviceUSB[i].path, '/')) == NULL)
+            continue;
+        if (sub) {
+            snprintf (key, sizeof(key), "%s/", port);
+            if (strstr (devpath, key) != NULL)
+                return i;
+        }
+        else if (((ptr = strrchr (devpath, '/')) != NULL) && !strcmp (ptr, port))
+            return i;
+    }
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+// usb device add -> 시간 기록, block disk add -> hotplug test thread 실행
+//------------------------------------------------------------------------------
+static void usb_hotplug_event (struct uevent *ev)
+{
+    struct usb_hotplug_job *job;
+    pthread_t thread;
+    int id;
+
+    if (!strcmp (ev->subsystem, "usb") && !strcmp (ev->devtype, "usb_device")) {
+        if ((id = usb_hotplug_port (ev->devpath, 0)) < 0)
+            return;
+        pthread_mutex_lock (&UsbHotplugMutex);
+        UsbHotplug[id].plug_ms = strcmp (ev->action, "add") ? 0 : ev->time_ms;
+        pthread_mutex_unlock (&UsbHotplugMutex);
+        return;
+    }
+    if (strcmp (ev->subsystem, "block") || strcmp (ev->devtype, "disk") || strcmp (ev->action, "add"))
+        return;
+    if ((id = usb_hotplug_port (ev->devpath, 1)) < 0)
+        return;
+    if ((job = calloc (1, sizeof(struct usb_hotplug_job))) == NULL)
+        return;
+
+    pthread_mutex_lock (&UsbHotplugMutex);
+    job->id      = id;
+    // usb device add event를 받지 못한 경우 (init 전 연결) -1
+    job->enum_ms = UsbHotplug[id].plug_ms ? (int)(ev->time_ms - UsbHotplug[id].plug_ms) : -1;
+    UsbHotplug[id].plug_ms = 0;
+    pthread_mutex_unlock (&UsbHotplugMutex);
+
+    // uevent thread를 막지 않도록 test는 별도 thread에서 실행
+    if (pthread_create (&thread, NULL, usb_hotplug_thread, job)) {
+        free (job);
+        return;
+    }
+    pthread_detach (thread);
+}
+
+//------------------------------------------------------------------------------
+// usb, scsi, block uevent (device 연결/제거) 수신시 block device name cache 무효화
+//------------------------------------------------------------------------------
+static void usb_uevent (struct uevent *ev)
+{
+    if (ev->subsystem[0] && strcmp (ev->subsystem, "usb") &&
+        strcmp (ev->subsystem, "scsi") && strcmp (ev->subsystem, "block"))
+        return;
+
+    pthread_mutex_lock (&UsbBlkMutex);
+    // 0은 cache 없음으로 사용
+    if (++UsbBlkGen == 0)
+        UsbBlkGen = 1;
+    pthread_mutex_unlock (&UsbBlkMutex);
+
+    usb_hotplug_event (ev);
+}
+
+//------------------------------------------------------------------------------
+// hotplug 결과 (queue에서 가장 오래된 결과 1개). return status, value = read MB/s
+// extended resp = enum time (ms, -1 = 결과 없음), link speed, read MB/s, 남은 결과 수
+//------------------------------------------------------------------------------
+static int usb_hotplug (int id, int *value)
+{
+    struct usb_hotplug *hp = &UsbHotplug[id];
+    struct usb_hotplug_result r;
+
+    pthread_mutex_lock (&UsbHotplugMutex);
+    if (!hp->count) {
+        pthread_mutex_unlock (&UsbHotplugMutex);
+        device_resp_ext ("%d,%d,%d,%d", -1, 0, 0, 0);
+        return 0;
+    }
+    r = hp->q[hp->head];
+    hp->head = (hp->head +1) % USB_HOTPLUG_QUEUE;
+    hp->count--;
+    device_resp_ext ("%d,%d,%d,%d", r.enum_ms, r.speed, r.mbps, hp->count);
+    pthread_mutex_unlock (&UsbHotplugMutex);
+
+    *value = r.mbps;
+    return r.status;
+}
+
+//------------------------------------------------------------------------------
+// 모든 port 동시 측정. 연결된 port별 thread에서 같은 시간 동안 r/w 함.
+// write는 storage_raw_verify (scratch 영역 save/restore) 사용.
+//------------------------------------------------------------------------------
+struct usb_all_job {
+    pthread_t thread;
+    char node[64];
+    int mode, mbps;
+};
+
+// 모든 port thread가 생성된 후 동시에 시작
+static pthread_mutex_t UsbAllMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  UsbAllCond  = PTHREAD_COND_INITIALIZER;
+static int UsbAllStart = 0;
+
+static void *usb_all_thread (void *arg)
+{
+    struct usb_all_job *job = (struct usb_all_job *)arg;
+    struct sio_param  param;
+    struct sio_result result;
+    int ret;
+
+    sio_param_init (&param, job->mode);
+    param.size    = USB_ALL_SPAN;
+    param.time_ms = UsbALL.time_ms;
+
+    pthread_mutex_lock (&UsbAllMutex);
+    while (!UsbAllStart)
+        pthread_cond_wait (&UsbAllCond, &UsbAllMutex);
+    pthread_mutex_unlock (&UsbAllMutex);
+
+    if (job->mode == eSIO_WRITE)
+        ret = storage_raw_verify (job->node, -1, &param, &result);
+    else
+        ret = storage_io_run (job->node, &param, &result);
+
+    job->mbps = ret ? result.mbps : 0;
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+// return status, value = 합계 MB/s. extended resp = 합계, port별 MB/s (연결되지 않은 port = 0)
+//------------------------------------------------------------------------------
+static int usb_all (int mode, int *value)
+{
+    struct usb_all_job job [eUSB_END];
+    char name[32];
+    int i, n = 0, sum = 0, min, status = 1;
+
+    UsbAllStart = 0;
+    memset (job, 0, sizeof(job));
+    for (i = 0; i < eUSB_END; i++) {
+        if ((access (DeviceUSB[i].path, R_OK) != 0) || !usb_blk_name (i, name))
+            continue;
+        sprintf (job[i].node, "/dev/%s", name);
+        job[i].mode = mode;
+        if (pthread_create (&job[i].thread, NULL, usb_all_thread, &job[i])) {
+            printf ("%s : %s thread create error!\n", __func__, job[i].node);
+            job[i].node[0] = 0;
+            status = 0;
+            continue;
+        }
+        n++;
+    }
+
+    pthread_mutex_lock (&UsbAllMutex);
+    UsbAllStart = 1;
+    pthread_cond_broadcast (&UsbAllCond);
+    pthread_mutex_unlock (&UsbAllMutex);
+
+    if (!n)
+        return 0;
+
+    for (i = 0; i < eUSB_END; i++) {
+        if (!job[i].node[0])
+            continue;
+        pthread_join (job[i].thread, NULL);
+
+        min  = (mode == eSIO_WRITE) ? DeviceUSB[i].w_min : DeviceUSB[i].r_min;
+        sum += job[i].mbps;
+        if (job[i].mbps < (min * UsbALL.port_pct / 100))
+            status = 0;
+
+        printf ("%s : %s (%s, hub %d) %d MB/s\n", __func__, DeviceUSB[i].path,
+            job[i].node, usb_root_hub (i), job[i].mbps);
+    }
+
+    device_resp_ext ("%d,%d,%d,%d,%d", sum, job[eUSB_30].mbps, job[eUSB_20].mbps,
+        job[eUSB_OTG].mbps, job[eUSB_EXTRA].mbps);
+
+    *value = sum;
+    min = (mode == eSIO_WRITE) ? UsbALL.wr_min : UsbALL.rd_min;
+    return (status && (sum >= min)) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// block size sweep (4K ~ 16M). scratch 영역을 1번 save/restore 하며 block size별 read/write 측정.
+// return status (sweep_min 기준), value = 최대 read MB/s
+// extended resp = 최대 read, 최대 write MB/s, 기준 미달 block size (KB, 0 = 없음), point 수
+//------------------------------------------------------------------------------
+static int usb_sweep (int id, int *value)
+{
+    struct usb_sweep *sw = &UsbSweep[id];
+    struct usb_sweep_min *m;
+    struct sio_param param;
+    int bs [USB_SWEEP_POINTS], rd [USB_SWEEP_POINTS], wr [USB_SWEEP_POINTS];
+    int i, j, rd_max = 0, wr_max = 0, fail_kb = 0;
+    char name[32], node[64];
+
+    if (!usb_blk_name (id, name))
+        return 0;
+
+    sprintf (node, "/dev/%s", name);
+    for (i = 0; i < USB_SWEEP_POINTS; i++)
+        bs[i] = USB_SWEEP_BS << i;
+
+    sio_param_init (&param, eSIO_READ);
+    param.qd      = UsbSWEEP.qd;
+    param.size    = (long long)UsbSWEEP.span_mb * 1024 * 1024;
+    param.time_ms = UsbSWEEP.time_ms;
+
+    if (!storage_raw_sweep (node, -1, &param, bs, USB_SWEEP_POINTS, rd, wr))
+        return 0;
+
+    printf ("%s : %s (%s) block size sweep (KB rd/wr MB/s)\n", __func__, DeviceUSB[id].path, node);
+    for (i = 0; i < USB_SWEEP_POINTS; i++) {
+        printf ("%d %d/%d%s", bs[i] / 1024, rd[i], wr[i],
+            ((i == (USB_SWEEP_POINTS -1)) || ((i % 7) == 6)) ? "\n" : ", ");
+        if (rd[i] > rd_max)     rd_max = rd[i];
+        if (wr[i] > wr_max)     wr_max = wr[i];
+
+        for (j = 0; j < USB_SWEEP_MIN_MAX; j++) {
+            m = &UsbSweepMin[j];
+            if (!m->bs_kb || ((m->bs_kb * 1024) != bs[i]))
+                continue;
+            if ((rd[i] < (DeviceUSB[id].r_min * m->rd_pct / 100)) ||
+                (wr[i] < (DeviceUSB[id].w_min * m->wr_pct / 100))) {
+                if (!fail_kb)
+                    fail_kb = m->bs_kb;
+            }
+        }
+    }
+
+    pthread_mutex_lock (&UsbSweepMutex);
+    memcpy (sw->rd, rd, sizeof(rd));
+    memcpy (sw->wr, wr, sizeof(wr));
+    sw->count = USB_SWEEP_POINTS;
+    sw->pos   = 0;
+    pthread_mutex_unlock (&UsbSweepMutex);
+
+    device_resp_ext ("%d,%d,%d,%d", rd_max, wr_max, fail_kb, USB_SWEEP_POINTS);
+
+    *value = rd_max;
+    return fail_kb ? 0 : 1;
+}
+
+//------------------------------------------------------------------------------
+// sweep 결과 (다음 point 1개). return 1 = point 있음, value = block size (KB)
+// extended resp = block size (KB), read, write MB/s, 남은 point 수
+//------------------------------------------------------------------------------
+static int usb_sweep_point (int id, int *value)
+{
+    struct usb_sweep *sw = &UsbSweep[id];
+    int i;
+
+    pthread_mutex_lock (&UsbSweepMutex);
+    if (sw->pos >= sw->count) {
+        pthread_mutex_unlock (&UsbSweepMutex);
+        device_resp_ext ("%d,%d,%d,%d", 0, 0, 0, 0);
+        return 0;
+    }
+    i = sw->pos++;
+    *value = (USB_SWEEP_BS << i) / 1024;
+    device_resp_ext ("%d,%d,%d,%d", *value, sw->rd[i], sw->wr[i], sw->count - sw->pos);
+    pthread_mutex_unlock (&UsbSweepMutex);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// usb port의 root hub(bus) number. (/sys/bus/usb/devices/8-1 = 8)
+//------------------------------------------------------------------------------
+int usb_root_hub (int id)
+{
+    const char *ptr;
+
+    if ((id < 0) || (id >= eUSB_END) || ((ptr = strrchr (DeviceUSB[id].path, '/')) == NULL))
+        return 0;
+
+    return atoi (ptr +1);
 }
 
 //------------------------------------------------------------------------------
 int usb_check (int id, char action, char *resp)
 {
-    int value = 0, status = 0;
+    int value = 0, status = 0, hub;
+
+    // hotplug, sweep 결과는 device가 제거된 후에도 읽을 수 있음
+    if ((id >= 0) && (id < eUSB_END) && ((action == 'E') || (action == 'K'))) {
+        status = (action == 'E') ? usb_hotplug (id, &value) : usb_sweep_point (id, &value);
+        sprintf (resp, "%06d", value);
+        return status;
+    }
+
+    // 모든 port 동시 read / write (dev_id 무시)
+    if ((action == 'A') || (action == 'C')) {
+        pthread_rwlock_wrlock (&UsbLock);
+        status = usb_all ((action == 'A') ? eSIO_READ : eSIO_WRITE, &value);
+        pthread_rwlock_unlock (&UsbLock);
+        sprintf (resp, "%06d", value);
+        return status;
+    }
 
-    if ((id >= eUSB_END) || ((access (DeviceUSB[id].path, R_OK)) != 0)) {
+    if ((id < 0) || (id >= eUSB_END) || ((access (DeviceUSB[id].path, R_OK)) != 0)) {
         sprintf (resp, "%06d", 0);
         return 0;
     }
 
+    pthread_rwlock_rdlock (&UsbLock);
+    // root hub lane에서 실행되는 r/w check는 hotplug test와 hub lock으로 직렬화
+    hub = (action == 'R') || (action == 'W') || (action == '5') || (action == '6') || (action == 'B');
+    if (hub)
+        usb_hub_lock (id);
     switch (action) {
         case 'I':
         case 'R':
             value  = (action == 'I') ?
-                    DeviceUSB[id].value : usb_rw (DeviceUSB[id].path, USB_R_CHECK);
+                    DeviceUSB[id].value : usb_rw (id);
             status = (value < DeviceUSB[id].r_min) ? 0 : 1;
             break;
         case 'W':
-            value  = usb_rw (DeviceUSB[id].path, USB_W_CHECK);
+            value  = usb_write (id);
             status = (value < DeviceUSB[id].w_min) ? 0 : 1;
             break;
+        // Sustained read / write
+        case '5':
+            status = usb_sustain (id, eSIO_READ,  DeviceUSB[id].r_min, &value);
+            break;
+        case '6':
+            status = usb_sustain (id, eSIO_WRITE, DeviceUSB[id].w_min, &value);
+            break;
+        // block size sweep (4K ~ 16M)
+        case 'B':
+            status = usb_sweep (id, &value);
+            break;
         case 'L':
             value  = usb_speed (DeviceUSB[id].path);
             status = (value != DeviceUSB[id].speed) ? 0 : 1;
@@ -167,6 +736,9 @@ int usb_check (int id, char action, char *resp)
         default :
             break;
     }
+    if (hub)
+        usb_hub_unlock (id);
+    pthread_rwlock_unlock (&UsbLock);
     sprintf (resp, "%06d", value);
     return status;
 }
@@ -176,6 +748,7 @@ static void default_config_write (const char *fname)
 {
     FILE *fp;
     char value [STR_PATH_LENGTH *2 +1];
+    int i;
 
     if ((fp = fopen(fname, "wt")) == NULL)
         return;
@@ -199,15 +772,94 @@ static void default_config_write (const char *fname)
         eUSB_EXTRA, DeviceUSB [eUSB_EXTRA].path, DEFAULT_USB20_R, DEFAULT_USB20_W, DEFAULT_USB20_L);
     fputs   (value, fp);
 
+    // hotplug auto-test
+    fputs   ("# hotplug : usb device add -> block device ready max(ms) \n", fp);
+    memset  (value, 0, sizeof(value));
+    sprintf (value, "hotplug,%d,\n", UsbEnumMax);
+    fputs   (value, fp);
+
+    // 모든 port 동시 측정
+    fputs   ("# all : rd total min(MB/s), wr total min(MB/s), port min(% of rd/wr_speed), time(ms) \n", fp);
+    memset  (value, 0, sizeof(value));
+    sprintf (value, "all,%d,%d,%d,%d,\n",
+        UsbALL.rd_min, UsbALL.wr_min, UsbALL.port_pct, UsbALL.time_ms);
+    fputs   (value, fp);
+
+    // block size sweep
+    fputs   ("# sweep : time per block size(ms), span(MB), queue depth \n", fp);
+    memset  (value, 0, sizeof(value));
+    sprintf (value, "sweep,%d,%d,%d,\n", UsbSWEEP.time_ms, UsbSWEEP.span_mb, UsbSWEEP.qd);
+    fputs   (value, fp);
+    fputs   ("# sweep_min : index, block size(KB, 0 = unused), rd min(% of rd_speed), wr min(% of wr_speed) \n", fp);
+    for (i = 0; i < USB_SWEEP_MIN_MAX; i++) {
+        memset  (value, 0, sizeof(value));
+        sprintf (value, "sweep_min,%d,%d,%d,%d,\n",
+            i, UsbSweepMin[i].bs_kb, UsbSweepMin[i].rd_pct, UsbSweepMin[i].wr_pct);
+        fputs   (value, fp);
+    }
+
     // file close
     fclose  (fp);
 }
 
+//------------------------------------------------------------------------------
+// keyword line (첫번째 항목이 문자인 line)
+//------------------------------------------------------------------------------
+static void config_keyword (char *value)
+{
+    char *ptr, *save;
+    int idx;
+
+    if ((ptr = strtok_r (value, ",", &save)) == NULL)
+        return;
+
+    if (!strcmp (ptr, "hotplug")) {
+        // hotplug, enum time max(ms)
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            UsbEnumMax = atoi (ptr);
+    }
+    else if (!strcmp (ptr, "all")) {
+        // all, rd total min(MB/s), wr total min(MB/s), port min(%), time(ms)
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            UsbALL.rd_min   = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            UsbALL.wr_min   = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            UsbALL.port_pct = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            UsbALL.time_ms  = atoi (ptr);
+    }
+    else if (!strcmp (ptr, "sweep")) {
+        // sweep, time per block size(ms), span(MB), queue depth
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            UsbSWEEP.time_ms = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            UsbSWEEP.span_mb = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            UsbSWEEP.qd      = atoi (ptr);
+    }
+    else if (!strcmp (ptr, "sweep_min")) {
+        // sweep_min, index, block size(KB), rd min(%), wr min(%)
+        if ((ptr = strtok_r (NULL, ",", &save)) == NULL)
+            return;
+        if (((idx = atoi (ptr)) < 0) || (idx >= USB_SWEEP_MIN_MAX))
+            return;
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            UsbSweepMin[idx].bs_kb  = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            UsbSweepMin[idx].rd_pct = atoi (ptr);
+        if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
+            UsbSweepMin[idx].wr_pct = atoi (ptr);
+    }
+    else
+        printf ("%s : unknown keyword %s\n", __func__, ptr);
+}
+
 //------------------------------------------------------------------------------
 static void default_config_read (void)
 {
     FILE *fp;
-    char fname [STR_PATH_LENGTH +1], value [STR_PATH_LENGTH +1], *ptr;
+    char fname [STR_PATH_LENGTH +1], value [STR_PATH_LENGTH +1], *ptr, *save;
     int dev_id;
 
     memset  (fname, 0, STR_PATH_LENGTH);
@@ -230,19 +882,23 @@ static void default_config_read (void)
             case '#':   case '\n':
                 break;
             default :
+                if (isalpha (value[0])) {
+                    config_keyword (value);
+                    break;
+                }
                 // default value write
                 // fputs   ("# info : dev_id, dev_node, rd_speed, wr_speed, link_speed \n", fp);
-                if ((ptr = strtok (value, ",")) != NULL) {
+                if ((ptr = strtok_r (value, ",", &save)) != NULL) {
                     dev_id = atoi (ptr);
-                    if ((ptr = strtok ( NULL, ",")) != NULL) {
+                    if ((ptr = strtok_r (NULL, ",", &save)) != NULL) {
                         memset (DeviceUSB[dev_id].path, 0, STR_PATH_LENGTH);
                         strcpy (DeviceUSB[dev_id].path, ptr);
                     }
-                    if ((ptr = strtok ( NULL, ",")) != NULL)
+                    if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
                        DeviceUSB[dev_id].r_min  = atoi (ptr);
-                    if ((ptr = strtok ( NULL, ",")) != NULL)
+                    if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
                        DeviceUSB[dev_id].w_min  = atoi (ptr);
-                    if ((ptr = strtok ( NULL, ",")) != NULL)
+                    if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
                        DeviceUSB[dev_id].speed = atoi (ptr);
                 }
                 break;
@@ -256,11 +912,20 @@ int usb_grp_init (void)
 {
     int i;
 
+    for (i = 0; i < USB_HUB_LOCK; i++)
+        pthread_mutex_init (&UsbHubMutex[i], NULL);
+
     default_config_read ();
 
+    // block device name cache 무효화, hotplug auto-test (실패시 매번 sysfs 검색)
+    usb_uevent_start (usb_uevent);
+
     for (i = 0; i < eUSB_END; i++) {
-        if ((access (DeviceUSB[i].path, R_OK)) == 0)
-            DeviceUSB[i].value = usb_rw (DeviceUSB[i].path, USB_R_CHECK);
+        if ((access (DeviceUSB[i].path, R_OK)) == 0) {
+            usb_hub_lock (i);
+            DeviceUSB[i].value = usb_rw (i);
+            usb_hub_unlock (i);
+        }
     }
 
     return 1;
@@ -20,6 +20,12 @@
 //------------------------------------------------------------------------------
 // Define the Device ID for the USB group.
 //------------------------------------------------------------------------------
+// action : 'I' init read speed, 'R' read, 'W' write (MB/s), 'L' link speed
+//          '5' sustained read, '6' sustained write (평균 MB/s)
+//          'A' 모든 port 동시 read, 'C' 모든 port 동시 write (합계 MB/s, dev_id 무시)
+//          'B' block size sweep 4K ~ 16M (최대 read MB/s), 'K' sweep 결과 1 point (block size KB)
+//          'E' hotplug auto-test 결과 (연결시 자동 측정된 read MB/s, enum time은 extended resp)
+//------------------------------------------------------------------------------
 // ODROID-M1S USB Port define
 enum {
     // USB 3.0
@@ -37,6 +43,7 @@ enum {
 //------------------------------------------------------------------------------
 // function prototype
 //------------------------------------------------------------------------------
+extern int usb_root_hub  (int id);
 extern int usb_check     (int id, char action, char *resp);
 extern int usb_grp_init  (void);
 
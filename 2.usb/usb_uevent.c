@@ -0,0 +1,146 @@
+//------------------------------------------------------------------------------
+/**
+ * @file usb_uevent.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Device Test library for ODROID-JIG. (kernel uevent listener)
+ * @version 0.2
+ * @date 2023-10-12
+ *
+ * @package apt install iperf3, nmap, ethtool, usbutils, alsa-utils
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+
+//------------------------------------------------------------------------------
+#include "../lib_dev_check.h"
+#include "usb_uevent.h"
+
+//------------------------------------------------------------------------------
+static int UeventFd = -1;
+static uevent_func UeventFunc = NULL;
+
+//------------------------------------------------------------------------------
+// "ACTION@DEVPATH\0KEY=VALUE\0KEY=VALUE\0..." 형식의 kernel message
+//------------------------------------------------------------------------------
+static int uevent_parse (const char *buf, int len, struct uevent *ev)
+{
+    const char *ptr = buf, *end = buf + len;
+    struct timespec now;
+
+    memset (ev, 0, sizeof(struct uevent));
+    // libudev message (udevd 재전송)는 kernel group에서 수신되지 않지만 확인
+    if (!strchr (buf, '@') || !strncmp (buf, "libudev", strlen ("libudev")))
+        return 0;
+
+    for (ptr += strlen (ptr) +1; ptr < end; ptr += strlen (ptr) +1) {
+        if      (!strncmp (ptr, "ACTION=", 7))
+            strncpy (ev->action,    ptr + 7, sizeof(ev->action) -1);
+        else if (!strncmp (ptr, "DEVPATH=", 8))
+            strncpy (ev->devpath,   ptr + 8, sizeof(ev->devpath) -1);
+        else if (!strncmp (ptr, "SUBSYSTEM=", 10))
+            strncpy (ev->subsystem, ptr + 10, sizeof(ev->subsystem) -1);
+        else if (!strncmp (ptr, "DEVTYPE=", 8))
+            strncpy (ev->devtype,   ptr + 8, sizeof(ev->devtype) -1);
+        else if (!strncmp (ptr, "DEVNAME=", 8))
+            strncpy (ev->devname,   ptr + 8, sizeof(ev->devname) -1);
+    }
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    ev->time_ms = now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+
+    return (ev->action[0] && ev->devpath[0]) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+static void *uevent_thread (void *arg)
+{
+    struct uevent ev;
+    char buf [UEVENT_BUF_SIZE];
+    int len;
+
+    (void)arg;
+    while (1) {
+        if ((len = recv (UeventFd, buf, sizeof(buf) -1, 0)) <= 0) {
+            if ((len < 0) && (errno == EINTR))
+                continue;
+            // ENOBUFS : event 유실. 수신은 계속하며 handler에 알리기 위해 빈 change event 전달.
+            if ((len < 0) && (errno == ENOBUFS)) {
+                memset (&ev, 0, sizeof(ev));
+                strcpy (ev.action, "change");
+                UeventFunc (&ev);
+                continue;
+            }
+            // 그 외 error는 listener 종료. (usb_uevent_running() = 0, cache 대신 sysfs 검색)
+            printf ("%s : netlink recv error! (%s)\n", __func__,
+                len ? strerror (errno) : "socket closed");
+            close (UeventFd);
+            UeventFd = -1;
+            break;
+        }
+        buf[len] = 0;
+        if (uevent_parse (buf, len, &ev))
+            UeventFunc (&ev);
+    }
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+// uevent listener 시작 (1회만 가능). return 0 = netlink socket error (root 권한 필요)
+//------------------------------------------------------------------------------
+int usb_uevent_start (uevent_func func)
+{
+    struct sockaddr_nl addr;
+    pthread_t thread;
+    int fd;
+
+    if (UeventFd >= 0)
+        return 1;
+
+    if ((fd = socket (AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT)) < 0) {
+        printf ("%s : netlink socket error! (%s)\n", __func__, strerror (errno));
+        return 0;
+    }
+
+    memset (&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_pid    = 0;
+    // kernel uevent group
+    addr.nl_groups = 1;
+
+    if (bind (fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        printf ("%s : netlink bind error! (%s)\n", __func__, strerror (errno));
+        close (fd);
+        return 0;
+    }
+
+    UeventFd   = fd;
+    UeventFunc = func;
+    if (pthread_create (&thread, NULL, uevent_thread, NULL)) {
+        UeventFd = -1;
+        close (fd);
+        return 0;
+    }
+    pthread_detach (thread);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+int usb_uevent_running (void)
+{
+    return (UeventFd >= 0) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
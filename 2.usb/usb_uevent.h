@@ -0,0 +1,51 @@
+//------------------------------------------------------------------------------
+/**
+ * @file usb_uevent.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Device Test library for ODROID-JIG. (kernel uevent listener)
+ * @version 0.2
+ * @date 2023-10-12
+ *
+ * @package apt install iperf3, nmap, ethtool, usbutils, alsa-utils
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __USB_UEVENT_H__
+#define __USB_UEVENT_H__
+
+//------------------------------------------------------------------------------
+// NETLINK_KOBJECT_UEVENT (kernel group) 수신 thread
+//------------------------------------------------------------------------------
+#define UEVENT_BUF_SIZE     8192
+
+struct uevent {
+    // add, remove, change, bind ...
+    char action [16];
+    // /devices/... (sysfs path에서 /sys 제외)
+    char devpath [256];
+    // usb, scsi, block ...
+    char subsystem [32];
+    // disk, partition, usb_device, usb_interface ...
+    char devtype [32];
+    // block, char device name (sda ...)
+    char devname [32];
+
+    // 수신 시간 (CLOCK_MONOTONIC, ms)
+    long long time_ms;
+};
+
+// listener thread에서 호출됨.
+typedef void (*uevent_func) (struct uevent *ev);
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+extern int  usb_uevent_start    (uevent_func func);
+extern int  usb_uevent_running  (void);
+
+//------------------------------------------------------------------------------
+#endif  // __USB_UEVENT_H__
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
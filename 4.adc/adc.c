@@ -137,7 +137,7 @@ static void default_config_write (const char *fname)
 static void default_config_read (void)
 {
     FILE *fp;
-    char fname [STR_PATH_LENGTH +1], value [STR_PATH_LENGTH +1], *ptr;
+    char fname [STR_PATH_LENGTH +1], value [STR_PATH_LENGTH +1], *ptr, *save;
     int dev_id;
 
     memset  (fname, 0, STR_PATH_LENGTH);
@@ -162,15 +162,15 @@ static void default_config_read (void)
             default :
                 // default value write
                 // fputs   ("# info : dev_id, dev_node, max, min \n", fp);
-                if ((ptr = strtok (value, ",")) != NULL) {
+                if ((ptr = strtok_r (value, ",", &save)) != NULL) {
                     dev_id = atoi (ptr);
-                    if ((ptr = strtok ( NULL, ",")) != NULL) {
+                    if ((ptr = strtok_r (NULL, ",", &save)) != NULL) {
                         memset (DeviceADC[dev_id].path, 0, STR_PATH_LENGTH);
                         strcpy (DeviceADC[dev_id].path, ptr);
                     }
-                    if ((ptr = strtok ( NULL, ",")) != NULL)
+                    if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
                        DeviceADC[dev_id].max  = atoi (ptr);
-                    if ((ptr = strtok ( NULL, ",")) != NULL)
+                    if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
                        DeviceADC[dev_id].min  = atoi (ptr);
                 }
                 break;
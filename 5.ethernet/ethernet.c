@@ -96,13 +96,16 @@ struct device_ethernet DeviceETHERNET = {
     DEFAULT_IPERF_SERVER, DEFAULT_IPERF_SPEED, 0, 0, 0, 0, "", ""
 };
 
+// mac_str, mac_status, ip_str 보호. (ethernet_mac_str/ip_str은 check와 동시에 호출될 수 있음)
+static pthread_mutex_t EthernetMutex = PTHREAD_MUTEX_INITIALIZER;
+
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 static int get_eth0_ip (void)
 {
     int fd;
     struct ifreq ifr;
-    char if_info[20], *p_str;
+    char if_info[20], *p_str, *save;
 
     /* this entire function is almost copied from ethtool source code */
     /* Open control socket. */
@@ -126,12 +129,15 @@ static int get_eth0_ip (void)
     inet_ntop (AF_INET, ifr.ifr_addr.sa_data+2, if_info, sizeof(struct sockaddr));
 
     /* aaa.bbb.ccc.ddd 형태로 저장됨 (16 bytes) */
-    memcpy (DeviceETHERNET.ip_str, if_info, strlen(if_info));
+    pthread_mutex_lock   (&EthernetMutex);
+    memset  (DeviceETHERNET.ip_str, 0, sizeof(DeviceETHERNET.ip_str));
+    strncpy (DeviceETHERNET.ip_str, if_info, sizeof(DeviceETHERNET.ip_str) -1);
+    pthread_mutex_unlock (&EthernetMutex);
 
-    if ((p_str = strtok (if_info, ".")) != NULL) {
-        strtok (NULL, "."); strtok (NULL, ".");
+    if ((p_str = strtok_r (if_info, ".", &save)) != NULL) {
+        strtok_r (NULL, ".", &save); strtok_r (NULL, ".", &save);
 
-        if ((p_str = strtok (NULL, ".")) != NULL)
+        if ((p_str = strtok_r (NULL, ".", &save)) != NULL)
             return atoi (p_str);
     }
     return 0;
@@ -161,6 +167,8 @@ SERVER_BUSY:
                 if ((pstr = strstr (cmd_line, "MBytes")) != NULL) {
                     while (*pstr != ' ')    pstr++;
                     value = atoi (pstr);
+                    // 소수점 포함 값 (binary frame)
+                    device_resp_ext ("%.2f", atof (pstr));
                 }
             }
         }
@@ -236,6 +244,21 @@ static int ethernet_ip_check (char action, char *resp)
     return value ? 1 : 0;
 }
 
+//------------------------------------------------------------------------------
+static void ethernet_mac_update (char *efuse, int status)
+{
+    char mac_str[MAC_STR_SIZE +1];
+
+    memset (mac_str, 0, sizeof(mac_str));
+    if (status)
+        efuse_get_mac (efuse, mac_str);
+
+    pthread_mutex_lock   (&EthernetMutex);
+    memcpy (DeviceETHERNET.mac_str, mac_str, sizeof(mac_str));
+    DeviceETHERNET.mac_status = status;
+    pthread_mutex_unlock (&EthernetMutex);
+}
+
 //------------------------------------------------------------------------------
 static int ethernet_mac_write (const char *model)
 {
@@ -248,8 +271,7 @@ static int ethernet_mac_write (const char *model)
             memset (efuse, 0, sizeof(efuse));
             if (efuse_control (efuse, EFUSE_READ)) {
                 if (efuse_valid_check (efuse)) {
-                    memset (DeviceETHERNET.mac_str, 0, MAC_STR_SIZE);
-                    efuse_get_mac (efuse, DeviceETHERNET.mac_str);
+                    ethernet_mac_update (efuse, 1);
                     return 1;
                 }
             }
@@ -265,11 +287,13 @@ static int ethernet_mac_check (char action, char *resp)
     switch (action) {
         case 'I':   case 'R':   case 'W':
             if ((action == 'W') && !DeviceETHERNET.mac_status)
-                DeviceETHERNET.mac_status = ethernet_mac_write ("m1s");
+                ethernet_mac_write ("m1s");
 
             /* 001E06aabbcc 형태로 저장이며, 앞의 6바이트는 고정이므로 하위 6바이트만 전송함. */
             if (DeviceETHERNET.mac_status) {
                 strncpy (resp, &DeviceETHERNET.mac_str[6], 6);
+                // full mac (binary frame)
+                device_resp_ext ("%s", DeviceETHERNET.mac_str);
                 return 1;
             }
             break;
@@ -352,10 +376,12 @@ static int ethernet_link_check (char action, char *resp)
 //------------------------------------------------------------------------------
 void ethernet_ip_str (char *ip_str)
 {
+    pthread_mutex_lock   (&EthernetMutex);
     if (DeviceETHERNET.ip_lsb)
         memcpy (ip_str, DeviceETHERNET.ip_str, strlen (DeviceETHERNET.ip_str));
     else
         sprintf (ip_str, "%03d.%03d.%03d.%03d", 0, 0, 0, 0);
+    pthread_mutex_unlock (&EthernetMutex);
 }
 
 //------------------------------------------------------------------------------
@@ -363,10 +389,12 @@ void ethernet_ip_str (char *ip_str)
 //------------------------------------------------------------------------------
 void ethernet_mac_str (char *mac_str)
 {
+    pthread_mutex_lock   (&EthernetMutex);
     if (DeviceETHERNET.mac_status)
         memcpy (mac_str, DeviceETHERNET.mac_str, strlen (DeviceETHERNET.mac_str));
     else
         sprintf (mac_str, "%012d", 0);
+    pthread_mutex_unlock (&EthernetMutex);
 }
 
 //------------------------------------------------------------------------------
@@ -405,7 +433,7 @@ static void default_config_write (const char *fname)
 static void default_config_read (void)
 {
     FILE *fp;
-    char fname [STR_PATH_LENGTH +1], value [STR_PATH_LENGTH +1], *ptr;
+    char fname [STR_PATH_LENGTH +1], value [STR_PATH_LENGTH +1], *ptr, *save;
 
     memset  (fname, 0, STR_PATH_LENGTH);
     sprintf (fname, "%sjig-%s.cfg", CONFIG_FILE_PATH, "ethernet");
@@ -429,11 +457,11 @@ static void default_config_read (void)
             default :
                 // default value write
                 // fputs   ("# info : iperf server ip, iperf speed \n", fp);
-                if ((ptr = strtok ( value, ",")) != NULL) {
+                if ((ptr = strtok_r (value, ",", &save)) != NULL) {
                     memset (DeviceETHERNET.iperf_server_ip, 0, STR_PATH_LENGTH);
                     strcpy (DeviceETHERNET.iperf_server_ip, ptr);
                 }
-                if ((ptr = strtok ( NULL, ",")) != NULL)
+                if ((ptr = strtok_r (NULL, ",", &save)) != NULL)
                     DeviceETHERNET.iperf_speed = atoi (ptr);
                 break;
         }
@@ -445,6 +473,7 @@ static void default_config_read (void)
 int ethernet_grp_init (void)
 {
     char efuse [EFUSE_UUID_SIZE];
+    int mac_status;
 
     memset (efuse, 0, sizeof (efuse));
 
@@ -462,19 +491,17 @@ int ethernet_grp_init (void)
     }
     // mac status & value
     if (efuse_control (efuse, EFUSE_READ)) {
-        DeviceETHERNET.mac_status = efuse_valid_check (efuse);
-        if (!DeviceETHERNET.mac_status && DeviceETHERNET.ip_lsb) {
+        mac_status = efuse_valid_check (efuse);
+        if (!mac_status && DeviceETHERNET.ip_lsb) {
             if (ethernet_mac_write ("m1s")) {
                 memset (efuse, 0, sizeof (efuse));
                 efuse_control (efuse, EFUSE_READ);
-                DeviceETHERNET.mac_status = efuse_valid_check (efuse);
+                mac_status = efuse_valid_check (efuse);
             }
             else
                 printf ("%s : ethernet mac write error! (m1s)\n", __func__);
         }
-
-        if (DeviceETHERNET.mac_status)
-            efuse_get_mac (efuse, DeviceETHERNET.mac_str);
+        ethernet_mac_update (efuse, mac_status);
     }
     return 1;
 }
@@ -100,68 +100,84 @@ static int find_file_path (const char *fname, char *file_path)
 }
 
 //------------------------------------------------------------------------------
-// thread control variable
+// thread control variable (AudioMutex로 보호됨)
 //------------------------------------------------------------------------------
-pthread_mutex_t audio_mutex;
-pthread_t audio_thread;
+static pthread_mutex_t AudioMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  AudioCond  = PTHREAD_COND_INITIALIZER;
+static pthread_t audio_thread;
 
-volatile int isAudioBusy = 0, AudioPlayTime = 0, AudioEnable = 0;
-volatile char *AudioFileName = NULL;
+static int AudioEnable = 0, AudioPlayTime = 0;
+static const char *AudioFileName = NULL;
 
 //------------------------------------------------------------------------------
 void *audio_thread_func (void *arg)
 {
     FILE *fp;
-    char cmd [STR_PATH_LENGTH];
+    char cmd [STR_PATH_LENGTH *2 +1];
 
+    (void)arg;
+    pthread_mutex_lock (&AudioMutex);
     while (1) {
-        if (!isAudioBusy && AudioEnable) {
-            pthread_mutex_lock   (&audio_mutex);
-            isAudioBusy = 1;
-            pthread_mutex_unlock (&audio_mutex);
-
-            memset (cmd, 0, sizeof(cmd));
-            if ((AudioFileName != NULL) && AudioPlayTime) {
-                sprintf (cmd, "aplay -Dhw:1,0 %s -d %d && sync",
-                    AudioFileName, AudioPlayTime);
-                if ((fp = popen (cmd, "r")) != NULL)
-                    pclose(fp);
-            }
+        while (!AudioEnable)
+            pthread_cond_wait (&AudioCond, &AudioMutex);
 
-            pthread_mutex_lock   (&audio_mutex);
-            isAudioBusy = 0;    AudioEnable = 0;
-            pthread_mutex_unlock (&audio_mutex);
-        }
-        usleep (1000);
+        memset (cmd, 0, sizeof(cmd));
+        if ((AudioFileName != NULL) && AudioPlayTime)
+            sprintf (cmd, "aplay -Dhw:1,0 %s -d %d && sync", AudioFileName, AudioPlayTime);
+        pthread_mutex_unlock (&AudioMutex);
+
+        if (cmd[0] && ((fp = popen (cmd, "r")) != NULL))
+            pclose(fp);
+
+        // play 완료 (audio_wait_stop 대기중인 thread wake up)
+        pthread_mutex_lock (&AudioMutex);
+        AudioEnable = 0;
+        pthread_cond_broadcast (&AudioCond);
     }
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+// play 중인 audio가 끝날때 까지 대기 (max sec). AudioMutex lock 상태에서 호출.
+// return 1 : audio stop, 0 : timeout
+//------------------------------------------------------------------------------
+static int audio_wait_stop (int sec)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_REALTIME, &ts);
+    ts.tv_sec += sec;
+
+    while (AudioEnable)
+        if (pthread_cond_timedwait (&AudioCond, &AudioMutex, &ts) == ETIMEDOUT)
+            break;
+
+    return AudioEnable ? 0 : 1;
 }
 
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 int audio_check (int id, char action, char *resp)
 {
-    int value = 0, retry = PLAY_TIME_SEC + 1;;
+    int value = 0;
 
     if ((id >= eAUDIO_END) || (DeviceAUDIO[id].is_file != 1)) {
         sprintf (resp, "%06d", 0);
         return 0;
     }
 
+    pthread_mutex_lock (&AudioMutex);
     switch (action) {
         case 'C':   /* wait audio stop */
-            while (AudioEnable && retry--)  sleep (1);
-            value = retry ? 1 : 0;
+            value = audio_wait_stop (PLAY_TIME_SEC + 1);
             break;
         case 'W':
-            while (AudioEnable && retry--)  sleep (1);
-
-            if (retry) {
-                pthread_mutex_lock   (&audio_mutex);
+            if (audio_wait_stop (PLAY_TIME_SEC + 1)) {
                 AudioFileName = DeviceAUDIO[id].path;
                 AudioPlayTime = DeviceAUDIO[id].play_time;
-                AudioEnable = 1;
+                AudioEnable   = 1;
                 value = DeviceAUDIO[id].is_file;
-                pthread_mutex_unlock (&audio_mutex);
+                pthread_cond_broadcast (&AudioCond);
             }
             else
                 printf ("audio busy\n");
@@ -170,6 +186,8 @@ int audio_check (int id, char action, char *resp)
         default :
             break;
     }
+    pthread_mutex_unlock (&AudioMutex);
+
     sprintf (resp, "%06d", value);
     return value;
 }
@@ -0,0 +1,461 @@
+//------------------------------------------------------------------------------
+/**
+ * @file lib_dev_async.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Device Test library for ODROID-JIG. (asynchronous device check)
+ * @version 0.2
+ * @date 2023-10-12
+ *
+ * @package apt install iperf3, nmap, ethtool, usbutils, alsa-utils
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+
+//------------------------------------------------------------------------------
+#include "lib_dev_check.h"
+
+//------------------------------------------------------------------------------
+// 같은 lane(device_check_lane)의 request는 요청 순서대로 1개씩 실행되며,
+// 다른 lane의 request는 worker thread에서 동시에 실행됨.
+// response delay(msg extra)는 worker를 잡고 있지 않도록 timer thread에서 처리.
+//------------------------------------------------------------------------------
+static pthread_mutex_t AsyncMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  WorkCond   = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  DoneCond   = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  TimerCond;
+
+static struct dev_async *WaitHead  = NULL, *WaitTail = NULL;
+static struct dev_async *DoneHead  = NULL, *DoneTail = NULL;
+static struct dev_async *TimerHead = NULL;
+
+// 실행중인 lane
+static int BusyLane [ASYNC_WORKER_MAX];
+static int AsyncStarted = 0;
+static int EventFd = -1;
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static int lane_busy (int lane)
+{
+    int i;
+
+    if (lane)
+        for (i = 0; i < ASYNC_WORKER_MAX; i++)
+            if (BusyLane[i] == lane)
+                return 1;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static void ts_add_ms (struct timespec *ts, int ms)
+{
+    clock_gettime (CLOCK_MONOTONIC, ts);
+    ts->tv_sec  += ms / 1000;
+    ts->tv_nsec += (ms % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+//------------------------------------------------------------------------------
+static int ts_cmp (struct timespec *a, struct timespec *b)
+{
+    if (a->tv_sec != b->tv_sec)
+        return (a->tv_sec < b->tv_sec) ? -1 : 1;
+    if (a->tv_nsec != b->tv_nsec)
+        return (a->tv_nsec < b->tv_nsec) ? -1 : 1;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// AsyncMutex lock 상태에서 호출. callback은 unlock 상태에서 실행함.
+//------------------------------------------------------------------------------
+static void req_complete (struct dev_async *req)
+{
+    if (req->cb != NULL) {
+        pthread_mutex_unlock (&AsyncMutex);
+        req->cb (req, req->arg);
+        free (req);
+        pthread_mutex_lock   (&AsyncMutex);
+        return;
+    }
+
+    // polling request는 handle 소유자만 확인하므로 completion queue에 넣지 않음
+    if (req->poll) {
+        req->state = eASYNC_DONE;
+        req->next  = NULL;
+        pthread_cond_broadcast (&DoneCond);
+        return;
+    }
+
+    req->state = eASYNC_DONE;
+    req->next  = NULL;
+    if (DoneTail != NULL)   DoneTail->next = req;
+    else                    DoneHead = req;
+    DoneTail = req;
+
+    if (EventFd >= 0) {
+        uint64_t cnt = 1;
+        if (write (EventFd, &cnt, sizeof(cnt)) != sizeof(cnt))
+            printf ("%s : eventfd write error!\n", __func__);
+    }
+    pthread_cond_broadcast (&DoneCond);
+}
+
+//------------------------------------------------------------------------------
+// completion queue에서 제거. AsyncMutex lock 상태에서 호출.
+//------------------------------------------------------------------------------
+static void done_remove (struct dev_async *req)
+{
+    struct dev_async *prev = NULL, *cur;
+
+    for (cur = DoneHead; cur != NULL; prev = cur, cur = cur->next) {
+        if (cur != req)
+            continue;
+
+        if (prev != NULL)   prev->next = cur->next;
+        else                DoneHead   = cur->next;
+        if (DoneTail == cur)
+            DoneTail = prev;
+
+        if (EventFd >= 0) {
+            uint64_t cnt;
+            if (read (EventFd, &cnt, sizeof(cnt)) != sizeof(cnt))
+                printf ("%s : eventfd read error!\n", __func__);
+        }
+        break;
+    }
+    req->next = NULL;
+}
+
+//------------------------------------------------------------------------------
+// 실행 가능한 첫번째 request. lane이 실행중이 아니라면 해당 lane의 가장 앞선 request임.
+//------------------------------------------------------------------------------
+static struct dev_async *req_pick (void)
+{
+    struct dev_async *prev = NULL, *req;
+
+    for (req = WaitHead; req != NULL; prev = req, req = req->next) {
+        if (lane_busy (req->lane))
+            continue;
+
+        if (prev != NULL)   prev->next = req->next;
+        else                WaitHead   = req->next;
+        if (WaitTail == req)
+            WaitTail = prev;
+
+        req->next = NULL;
+        return req;
+    }
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void *async_worker (void *arg)
+{
+    struct dev_async *req;
+    int *busy = (int *)arg, delay;
+
+    pthread_mutex_lock (&AsyncMutex);
+    while (1) {
+        if ((req = req_pick ()) == NULL) {
+            pthread_cond_wait (&WorkCond, &AsyncMutex);
+            continue;
+        }
+        *busy      = req->lane;
+        req->state = eASYNC_RUN;
+        pthread_mutex_unlock (&AsyncMutex);
+
+        memset (req->resp, 0, sizeof(req->resp));
+        req->status = device_check_run (&req->msg, req->resp);
+        strncpy (req->resp_ext, device_resp_ext_get (), SIZE_RESP_EXT);
+        delay = device_msg_delay (&req->msg);
+
+        pthread_mutex_lock   (&AsyncMutex);
+        *busy = 0;
+        pthread_cond_broadcast (&WorkCond);
+
+        if (delay > 0) {
+            struct dev_async **pos = &TimerHead;
+
+            ts_add_ms (&req->due, delay);
+            req->state = eASYNC_DELAY;
+            while ((*pos != NULL) && (ts_cmp (&(*pos)->due, &req->due) <= 0))
+                pos = &(*pos)->next;
+            req->next = *pos;
+            *pos = req;
+            pthread_cond_signal (&TimerCond);
+        }
+        else
+            req_complete (req);
+    }
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void *async_timer (void *arg)
+{
+    struct timespec now;
+    struct dev_async *req;
+
+    (void)arg;
+    pthread_mutex_lock (&AsyncMutex);
+    while (1) {
+        if (TimerHead == NULL) {
+            pthread_cond_wait (&TimerCond, &AsyncMutex);
+            continue;
+        }
+        clock_gettime (CLOCK_MONOTONIC, &now);
+        if (ts_cmp (&TimerHead->due, &now) > 0) {
+            pthread_cond_timedwait (&TimerCond, &AsyncMutex, &TimerHead->due);
+            continue;
+        }
+        req = TimerHead;
+        TimerHead = req->next;
+        req_complete (req);
+    }
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+int dev_async_init (int worker_cnt)
+{
+    pthread_condattr_t attr;
+    pthread_t thread;
+    int i;
+
+    pthread_mutex_lock (&AsyncMutex);
+    if (AsyncStarted) {
+        pthread_mutex_unlock (&AsyncMutex);
+        return 1;
+    }
+
+    pthread_condattr_init     (&attr);
+    pthread_condattr_setclock (&attr, CLOCK_MONOTONIC);
+    pthread_cond_init         (&TimerCond, &attr);
+    pthread_condattr_destroy  (&attr);
+
+    EventFd = eventfd (0, EFD_NONBLOCK | EFD_SEMAPHORE | EFD_CLOEXEC);
+
+    if ((worker_cnt <= 0) || (worker_cnt > ASYNC_WORKER_MAX))
+        worker_cnt = ASYNC_WORKER_CNT;
+
+    for (i = 0; i < worker_cnt; i++) {
+        if (pthread_create (&thread, NULL, async_worker, &BusyLane[i]))
+            break;
+        pthread_detach (thread);
+    }
+    if (!pthread_create (&thread, NULL, async_timer, NULL))
+        pthread_detach (thread);
+
+    AsyncStarted = 1;
+    pthread_mutex_unlock (&AsyncMutex);
+
+    printf ("%s : worker = %d\n", __func__, i);
+    return i ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// request 등록. return request (NULL = error)
+//------------------------------------------------------------------------------
+static struct dev_async *req_submit (void *msg, dev_async_cb cb, void *arg, int poll)
+{
+    struct dev_async *req;
+
+    if (!AsyncStarted && !dev_async_init (0))
+        return NULL;
+
+    if ((req = (struct dev_async *)calloc (1, sizeof(struct dev_async))) == NULL)
+        return NULL;
+
+    memcpy (&req->msg, msg, sizeof(struct msg_info));
+    req->lane   = device_check_lane (msg);
+    req->cb     = cb;
+    req->arg    = arg;
+    req->poll   = poll;
+    req->state  = eASYNC_WAIT;
+
+    pthread_mutex_lock   (&AsyncMutex);
+    if (WaitTail != NULL)   WaitTail->next = req;
+    else                    WaitHead = req;
+    WaitTail = req;
+    pthread_cond_signal  (&WorkCond);
+    pthread_mutex_unlock (&AsyncMutex);
+
+    return req;
+}
+
+//------------------------------------------------------------------------------
+// callback 또는 completion queue(cb == NULL)로 완료되는 request 등록. return 1 = 등록, 0 = error
+// request는 callback return 후 free 되거나 dev_async_get으로 가져간 쪽에서 free 하므로 handle은 없음.
+//------------------------------------------------------------------------------
+int dev_async_submit (void *msg, dev_async_cb cb, void *arg)
+{
+    return req_submit (msg, cb, arg, 0) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// polling용 request 등록. return request handle (NULL = error)
+// handle은 dev_async_done/dev_async_wait 후 dev_async_free 할 때까지 유효함.
+// 완료된 request는 completion queue에 들어가지 않으므로 dev_async_get으로 받을 수 없음.
+//------------------------------------------------------------------------------
+struct dev_async *dev_async_request (void *msg, void *arg)
+{
+    return req_submit (msg, NULL, arg, 1);
+}
+
+//------------------------------------------------------------------------------
+int dev_async_fd (void)
+{
+    if (!AsyncStarted)
+        dev_async_init (0);
+    return EventFd;
+}
+
+//------------------------------------------------------------------------------
+// 완료된 request를 완료 순서대로 가져옴. (NULL = 완료된 request 없음)
+//------------------------------------------------------------------------------
+struct dev_async *dev_async_get (void)
+{
+    struct dev_async *req;
+
+    pthread_mutex_lock   (&AsyncMutex);
+    if ((req = DoneHead) != NULL)
+        done_remove (req);
+    pthread_mutex_unlock (&AsyncMutex);
+
+    return req;
+}
+
+//------------------------------------------------------------------------------
+int dev_async_done (struct dev_async *req)
+{
+    int done;
+
+    pthread_mutex_lock   (&AsyncMutex);
+    done = (req->state == eASYNC_DONE);
+    pthread_mutex_unlock (&AsyncMutex);
+
+    return done;
+}
+
+//------------------------------------------------------------------------------
+// request 완료까지 대기 (cb == NULL인 request만 사용). return check status.
+//------------------------------------------------------------------------------
+int dev_async_wait (struct dev_async *req)
+{
+    pthread_mutex_lock   (&AsyncMutex);
+    while (req->state != eASYNC_DONE)
+        pthread_cond_wait (&DoneCond, &AsyncMutex);
+    if (!req->poll)
+        done_remove (req);
+    pthread_mutex_unlock (&AsyncMutex);
+
+    return req->status;
+}
+
+//------------------------------------------------------------------------------
+void dev_async_free (struct dev_async *req)
+{
+    // completion queue에 남아있는 request (dev_async_get으로 가져가지 않은 경우) 제거
+    pthread_mutex_lock   (&AsyncMutex);
+    if (!req->poll && (req->state == eASYNC_DONE))
+        done_remove (req);
+    pthread_mutex_unlock (&AsyncMutex);
+    free (req);
+}
+
+//------------------------------------------------------------------------------
+// batch check
+//------------------------------------------------------------------------------
+struct batch_ctx {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    int remain, pass;
+};
+
+struct batch_item {
+    struct batch_ctx *ctx;
+    char *resp_msg;
+};
+
+//------------------------------------------------------------------------------
+static void batch_done (struct dev_async *req, void *arg)
+{
+    struct batch_item *item = (struct batch_item *)arg;
+    struct batch_ctx  *ctx  = item->ctx;
+
+    device_resp_msg (&req->msg, req->status, req->resp, item->resp_msg);
+
+    pthread_mutex_lock   (&ctx->mutex);
+    ctx->pass += req->status ? 1 : 0;
+    if (--ctx->remain == 0)
+        pthread_cond_signal (&ctx->cond);
+    pthread_mutex_unlock (&ctx->mutex);
+}
+
+//------------------------------------------------------------------------------
+// msg : msg_info array, resp_msg : response frame array (count * msg_info size)
+// 서로 다른 lane의 check는 동시에 실행됨. return pass count.
+//------------------------------------------------------------------------------
+int device_check_batch (void *msg, int count, void *resp_msg)
+{
+    struct batch_ctx ctx;
+    struct batch_item *item;
+    int i, size = sizeof(struct msg_info);
+
+    if ((count <= 0) || ((item = calloc (count, sizeof(struct batch_item))) == NULL))
+        return 0;
+
+    pthread_mutex_init (&ctx.mutex, NULL);
+    pthread_cond_init  (&ctx.cond,  NULL);
+    ctx.remain = count;
+    ctx.pass   = 0;
+
+    for (i = 0; i < count; i++) {
+        item[i].ctx      = &ctx;
+        item[i].resp_msg = (char *)resp_msg + i * size;
+
+        if (!dev_async_submit ((char *)msg + i * size, batch_done, &item[i])) {
+            char resp[SIZE_RESP *2 +1];
+            int status;
+
+            memset (resp, 0, sizeof(resp));
+            status = device_check ((char *)msg + i * size, resp);
+            device_resp_msg ((char *)msg + i * size, status, resp, item[i].resp_msg);
+
+            pthread_mutex_lock   (&ctx.mutex);
+            ctx.pass += status ? 1 : 0;
+            ctx.remain--;
+            pthread_mutex_unlock (&ctx.mutex);
+        }
+    }
+
+    pthread_mutex_lock   (&ctx.mutex);
+    while (ctx.remain)
+        pthread_cond_wait (&ctx.cond, &ctx.mutex);
+    pthread_mutex_unlock (&ctx.mutex);
+
+    pthread_mutex_destroy (&ctx.mutex);
+    pthread_cond_destroy  (&ctx.cond);
+    free (item);
+
+    return ctx.pass;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+/**
+ * @file lib_dev_async.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Device Test library for ODROID-JIG. (asynchronous device check)
+ * @version 0.2
+ * @date 2023-10-12
+ *
+ * @package apt install iperf3, nmap, ethtool, usbutils, alsa-utils
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __LIB_DEV_ASYNC_H__
+#define __LIB_DEV_ASYNC_H__
+
+//------------------------------------------------------------------------------
+#include <time.h>
+
+//------------------------------------------------------------------------------
+// default worker thread count
+#define ASYNC_WORKER_CNT    eGROUP_END
+#define ASYNC_WORKER_MAX    32
+
+// request 등록 실패시 response (status = fail). event loop에서 check를 직접 실행하지 않음.
+#define ASYNC_RESP_BUSY     "BUSY"
+
+enum {
+    eASYNC_WAIT = 0,
+    eASYNC_RUN,
+    // check 완료, response delay(msg extra ms) 대기중
+    eASYNC_DELAY,
+    eASYNC_DONE,
+};
+
+struct dev_async;
+
+// completion callback. callback return 후 request는 자동으로 free 됨.
+typedef void (*dev_async_cb) (struct dev_async *req, void *arg);
+
+struct dev_async {
+    // request frame
+    struct msg_info msg;
+    // device_check_lane value
+    int lane;
+
+    // check result
+    int  status;
+    char resp[SIZE_RESP *2 +1];
+    // extended resp (device_resp_ext)
+    char resp_ext[SIZE_RESP_EXT +1];
+
+    // completion callback (NULL = completion queue)
+    dev_async_cb cb;
+    void *arg;
+
+    // control (library internal)
+    // poll : dev_async_request로 등록 (completion queue에 넣지 않음)
+    int state, poll;
+    struct timespec due;
+    struct dev_async *next;
+};
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+extern int  dev_async_init      (int worker_cnt);
+extern int  dev_async_submit    (void *msg, dev_async_cb cb, void *arg);
+// polling (dev_async_done, dev_async_wait) 용. handle은 dev_async_free 전까지 유효함.
+extern struct dev_async *dev_async_request (void *msg, void *arg);
+
+// completion queue (cb == NULL 인 request)
+// dev_async_fd는 eventfd이며 completion queue에 request가 있는 경우 readable 됨.
+extern int  dev_async_fd        (void);
+extern struct dev_async *dev_async_get (void);
+
+extern int  dev_async_done      (struct dev_async *req);
+extern int  dev_async_wait      (struct dev_async *req);
+extern void dev_async_free      (struct dev_async *req);
+
+// msg frame array를 실행하고 요청 순서대로 response frame array를 만듬.
+extern int  device_check_batch  (void *msg, int count, void *resp_msg);
+
+//------------------------------------------------------------------------------
+#endif  // __LIB_DEV_ASYNC_H__
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
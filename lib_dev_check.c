@@ -36,38 +36,302 @@
 //------------------------------------------------------------------------------
 int str_to_int (char *str, int str_size)
 {
-    char conv[10];
+    int value;
 
-    memset (conv, 0, sizeof(conv));
-    memcpy (conv, str, str_size);
-    return atoi (conv);
+    // 숫자가 아닌 문자가 포함된 경우 0
+    frame_digit (str, str_size, &value);
+    return value;
 }
 
 //------------------------------------------------------------------------------
-int device_check (void *msg, char *resp)
+//
+// Device group list
+//
+//------------------------------------------------------------------------------
+enum {
+    eGRP_INIT_NONE = 0,
+    eGRP_INIT_RUN,
+    eGRP_INIT_DONE,
+};
+
+struct device_grp {
+    // group name
+    const char *name;
+    // group init / check function
+    int (*init)  (void);
+    int (*check) (int id, char action, char *resp);
+    // shared resource (RES_BIT(eRES_xxx))
+    int res;
+};
+
+// group init thread control
+struct grp_init {
+    pthread_t thread;
+    int state, status, init_ms;
+};
+
+static struct device_grp DeviceGRP [eGROUP_END] = {
+    { "SYSTEM"     , system_grp_init  , system_check  , 0 },
+    { "STORAGE"    , storage_grp_init , storage_check , RES_BIT(eRES_BLOCK) },
+    { "USB"        , usb_grp_init     , usb_check     , RES_BIT(eRES_USB) },
+    { "HDMI"       , hdmi_grp_init    , hdmi_check    , 0 },
+    { "ADC"        , adc_grp_init     , adc_check     , 0 },
+    { "ETHERNET"   , ethernet_grp_init, ethernet_check, RES_BIT(eRES_ETH0) | RES_BIT(eRES_EFUSE) },
+    { "HEADER_GPIO", header_grp_init  , header_check  , RES_BIT(eRES_GPIO) },
+    { "AUDIO"      , audio_grp_init   , audio_check   , RES_BIT(eRES_AUDIO) },
+    { "LED"        , led_grp_init     , led_check     , 0 },
+    { "PWM"        , pwm_grp_init     , pwm_check     , 0 },
+};
+
+static struct grp_init GrpINIT [eGROUP_END];
+
+// 1 = group init은 해당 group의 첫 device_check에서 실행됨.
+static int LazyInit = 0;
+
+static pthread_mutex_t GrpMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  GrpCond  = PTHREAD_COND_INITIALIZER;
+
+static pthread_mutex_t ResMutex [eRES_END] = {
+    [0 ... eRES_END -1] = PTHREAD_MUTEX_INITIALIZER
+};
+
+// check lane(device) 별 lock. 처음 사용되는 lane에서 생성되며 free 되지 않음.
+struct lane_lock {
+    int lane;
+    pthread_mutex_t mutex;
+    struct lane_lock *next;
+};
+
+static struct lane_lock *LaneLock = NULL;
+static pthread_mutex_t LaneMutex = PTHREAD_MUTEX_INITIALIZER;
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static int elapsed_ms (struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return  (now.tv_sec  - start->tv_sec)  * 1000 +
+            (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+//------------------------------------------------------------------------------
+// 항상 낮은 bit부터 lock하여 deadlock이 발생하지 않도록 함.
+//------------------------------------------------------------------------------
+void device_res_lock (int res)
+{
+    int i;
+
+    for (i = 0; i < eRES_END; i++)
+        if (res & RES_BIT(i))
+            pthread_mutex_lock (&ResMutex[i]);
+}
+
+//------------------------------------------------------------------------------
+void device_res_unlock (int res)
+{
+    int i;
+
+    for (i = eRES_END -1; i >= 0; i--)
+        if (res & RES_BIT(i))
+            pthread_mutex_unlock (&ResMutex[i]);
+}
+
+//------------------------------------------------------------------------------
+static pthread_mutex_t *lane_mutex (int lane)
+{
+    struct lane_lock *l;
+
+    pthread_mutex_lock (&LaneMutex);
+    for (l = LaneLock; l != NULL; l = l->next)
+        if (l->lane == lane)
+            break;
+
+    if ((l == NULL) && ((l = calloc (1, sizeof(struct lane_lock))) != NULL)) {
+        l->lane = lane;
+        pthread_mutex_init (&l->mutex, NULL);
+        l->next  = LaneLock;
+        LaneLock = l;
+    }
+    pthread_mutex_unlock (&LaneMutex);
+
+    return (l != NULL) ? &l->mutex : NULL;
+}
+
+//------------------------------------------------------------------------------
+static int grp_init_run (int grp_id)
+{
+    struct device_grp *grp = &DeviceGRP[grp_id];
+    struct grp_init *init  = &GrpINIT[grp_id];
+    struct timespec start;
+    int status;
+
+    clock_gettime (CLOCK_MONOTONIC, &start);
+
+    device_res_lock   (grp->res);
+    status = grp->init ();
+    device_res_unlock (grp->res);
+
+    pthread_mutex_lock   (&GrpMutex);
+    init->status  = status;
+    init->init_ms = elapsed_ms (&start);
+    init->state   = eGRP_INIT_DONE;
+    pthread_cond_broadcast (&GrpCond);
+    pthread_mutex_unlock (&GrpMutex);
+
+    printf ("%s : %s ready. (status = %d, %d ms)\n",
+        __func__, grp->name, status, init->init_ms);
+    return status;
+}
+
+//------------------------------------------------------------------------------
+static void *grp_init_thread (void *arg)
+{
+    grp_init_run ((int)(long)arg);
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+// group init 완료까지 대기. return grp_init status.
+// lazy mode인 경우 처음 호출된 group의 init을 호출한 thread에서 실행함.
+//------------------------------------------------------------------------------
+int device_grp_ready (int grp_id)
+{
+    int status;
+
+    if ((grp_id < 0) || (grp_id >= eGROUP_END))
+        return 0;
+
+    pthread_mutex_lock   (&GrpMutex);
+    if (LazyInit && (GrpINIT[grp_id].state == eGRP_INIT_NONE)) {
+        GrpINIT[grp_id].state = eGRP_INIT_RUN;
+        pthread_mutex_unlock (&GrpMutex);
+        return grp_init_run (grp_id);
+    }
+    while (GrpINIT[grp_id].state == eGRP_INIT_RUN)
+        pthread_cond_wait (&GrpCond, &GrpMutex);
+    status = GrpINIT[grp_id].status;
+    pthread_mutex_unlock (&GrpMutex);
+
+    return status;
+}
+
+//------------------------------------------------------------------------------
+// check thread 별 extended resp. device_check_run 시작시 초기화 됨.
+//------------------------------------------------------------------------------
+static __thread char RespExt[SIZE_RESP_EXT +1];
+
+void device_resp_ext (const char *fmt, ...)
+{
+    va_list va;
+
+    va_start (va, fmt);
+    vsnprintf (RespExt, sizeof(RespExt), fmt, va);
+    va_end (va);
+}
+
+//------------------------------------------------------------------------------
+// 현재 thread에서 마지막으로 실행된 check의 extended resp. ("" = 없음)
+//------------------------------------------------------------------------------
+const char *device_resp_ext_get (void)
+{
+    return RespExt;
+}
+
+//------------------------------------------------------------------------------
+// response delay(msg extra) 없이 check만 실행. 여러 thread에서 동시에 호출 가능.
+// 같은 lane(device)의 check는 lane lock으로 1개씩 실행되며, lane 0은 lock 없이 실행.
+//------------------------------------------------------------------------------
+int device_check_run (void *msg, char *resp)
 {
     struct msg_info *m_info = (struct msg_info *)msg;
     int grp_id  = str_to_int (m_info->grp_id, SIZE_GRP_ID);
     int dev_id  = str_to_int (m_info->dev_id, SIZE_DEV_ID);
-    // extra data or delay ms
-    int extra   = str_to_int (m_info->extra, SIZE_EXTRA);
     char action = toupper    (m_info->action);
-    int status  = 0;
-
-    switch(grp_id) {
-        case eGROUP_SYSTEM:     status = system_check   (dev_id, action, resp); break;
-        case eGROUP_STORAGE:    status = storage_check  (dev_id, action, resp); break;
-        case eGROUP_USB:        status = usb_check      (dev_id, action, resp); break;
-        case eGROUP_HDMI:       status = hdmi_check     (dev_id, action, resp); break;
-        case eGROUP_ADC:        status = adc_check      (dev_id, action, resp); break;
-        case eGROUP_ETHERNET:   status = ethernet_check (dev_id, action, resp); break;
-        // ADC board check (server)
-        case eGROUP_HEADER:     status = header_check   (dev_id, action, resp); break;
-        case eGROUP_AUDIO:      status = audio_check    (dev_id, action, resp); break;
-        case eGROUP_LED:        status = led_check      (dev_id, action, resp); break;
-        case eGROUP_PWM:        status = pwm_check      (dev_id, action, resp); break;
-        default :               sprintf (resp, "%06d", 0);  break;
+    int status  = 0, lane;
+    pthread_mutex_t *mutex = NULL;
+
+    RespExt[0] = 0;
+    if ((grp_id >= 0) && (grp_id < eGROUP_END)) {
+        device_grp_ready (grp_id);
+
+        if ((lane = device_check_lane (msg)) != 0)
+            mutex = lane_mutex (lane);
+
+        if (mutex != NULL)  pthread_mutex_lock   (mutex);
+        status = DeviceGRP[grp_id].check (dev_id, action, resp);
+        if (mutex != NULL)  pthread_mutex_unlock (mutex);
     }
+    else
+        sprintf (resp, "%06d", 0);
+
+    return status;
+}
+
+//------------------------------------------------------------------------------
+// msg의 group id, response delay(ms) 값.
+//------------------------------------------------------------------------------
+int device_msg_grp (void *msg)
+{
+    return str_to_int (((struct msg_info *)msg)->grp_id, SIZE_GRP_ID);
+}
+
+//------------------------------------------------------------------------------
+int device_msg_delay (void *msg)
+{
+    return str_to_int (((struct msg_info *)msg)->extra, SIZE_EXTRA);
+}
+
+//------------------------------------------------------------------------------
+// 동시에 실행할 수 없는 check를 구분하는 lane 값. (0 = 다른 check와 동시 실행 가능)
+// 같은 lane의 check는 요청 순서대로 1개씩 실행됨. (device_check_run의 lane lock)
+// lane 0인 check는 module의 global data를 변경하지 않아야 함.
+//------------------------------------------------------------------------------
+#define CHECK_LANE(grp, sub)    ((((grp) +1) << 8) | ((sub) & 0xFF))
+
+int device_check_lane (void *msg)
+{
+    struct msg_info *m_info = (struct msg_info *)msg;
+    int grp_id  = str_to_int (m_info->grp_id, SIZE_GRP_ID);
+    int dev_id  = str_to_int (m_info->dev_id, SIZE_DEV_ID);
+    char action = toupper    (m_info->action);
+
+    switch (grp_id) {
+        // sysfs read only
+        case eGROUP_SYSTEM: case eGROUP_HDMI:   case eGROUP_ADC:
+            return 0;
+        case eGROUP_STORAGE:
+            // 같은 controller의 device는 순차 실행. ('A'는 storage module에서 모든 check를 대기)
+            // 'P', 'X'는 surface scan 상태만 변경 (scan은 background thread에서 실행)
+            if ((action == 'I') || (action == 'P') || (action == 'X'))
+                return 0;
+            return CHECK_LANE (grp_id, (action == 'A') ? 0xFF : storage_controller (dev_id));
+        case eGROUP_USB:
+            // 같은 root hub에 연결된 port는 bandwidth를 공유하므로 순차 실행.
+            if ((action == 'R') || (action == 'W') || (action == '5') || (action == '6') ||
+                (action == 'B'))
+                return CHECK_LANE (grp_id, usb_root_hub (dev_id));
+            // 모든 port 동시 측정은 usb module에서 다른 check를 대기
+            if ((action == 'A') || (action == 'C'))
+                return CHECK_LANE (grp_id, 0xFF);
+            return 0;
+        case eGROUP_LED:    case eGROUP_PWM:
+            return CHECK_LANE (grp_id, dev_id);
+        case eGROUP_ETHERNET:   case eGROUP_HEADER: case eGROUP_AUDIO:
+            return CHECK_LANE (grp_id, 0);
+        default :
+            return 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+int device_check (void *msg, char *resp)
+{
+    // extra data or delay ms
+    int extra   = device_msg_delay (msg);
+    int status  = device_check_run (msg, resp);
+
     // ms delay
     if (extra)
         usleep (extra * 1000);
@@ -75,19 +339,98 @@ int device_check (void *msg, char *resp)
     return status;
 }
 
+//------------------------------------------------------------------------------
+// check 결과를 response message(19 bytes)로 만듬. resp_msg는 msg_info 크기 이상.
+//------------------------------------------------------------------------------
+int device_resp_msg (void *msg, int status, const char *resp, void *resp_msg)
+{
+    struct msg_info *m_info = (struct msg_info *)msg;
+    struct msg_info *r_info = (struct msg_info *)resp_msg;
+    int len = strlen (resp);
+
+    memcpy (r_info, m_info, sizeof(struct msg_info));
+    r_info->start  = MSG_START;
+    r_info->cmd    = MSG_CMD_RESP;
+    r_info->action = status ? '1' : '0';
+    r_info->end    = MSG_END;
+
+    // "PASS", "FAIL" 등 6자리보다 짧은 resp는 space로 채움.
+    memset (r_info->extra, ' ', SIZE_RESP);
+    memcpy (r_info->extra, resp, (len > SIZE_RESP) ? SIZE_RESP : len);
+    return sizeof(struct msg_info);
+}
+
+//------------------------------------------------------------------------------
+// response message에서 resp data를 분리. return check status.
+//------------------------------------------------------------------------------
+int device_resp_parse (void *resp_msg, char *resp)
+{
+    struct msg_info *r_info = (struct msg_info *)resp_msg;
+    int i;
+
+    if ((r_info->start != MSG_START) || (r_info->cmd != MSG_CMD_RESP) ||
+        (r_info->end != MSG_END))
+        return -1;
+
+    memcpy (resp, r_info->extra, SIZE_RESP);
+    for (i = SIZE_RESP; i > 0 && resp[i-1] == ' '; i--);
+    resp[i] = 0;
+
+    return (r_info->action == '1') ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// 각 group의 init을 thread로 동시에 실행하며, 같은 resource를 사용하는 group은
+// 순차적으로 실행됨. 모든 group의 init이 완료되면 return.
 //------------------------------------------------------------------------------
 int device_setup (void)
 {
-    system_grp_init ();
-    storage_grp_init ();
-    usb_grp_init ();
-    hdmi_grp_init ();
-    adc_grp_init ();
-    ethernet_grp_init ();
-    header_grp_init ();
-    audio_grp_init ();
-    led_grp_init ();
-    pwm_grp_init ();
+    struct timespec start;
+    // 이번 호출에서 생성한 thread만 join 함. (이미 join 되었거나 lazy mode로 실행된 group 제외)
+    int i, created [eGROUP_END];
+
+    clock_gettime (CLOCK_MONOTONIC, &start);
+
+    pthread_mutex_lock   (&GrpMutex);
+    for (i = 0; i < eGROUP_END; i++) {
+        created[i] = 0;
+        if (GrpINIT[i].state != eGRP_INIT_NONE)
+            continue;
+        GrpINIT[i].state = eGRP_INIT_RUN;
+        if (pthread_create (&GrpINIT[i].thread, NULL, grp_init_thread, (void *)(long)i)) {
+            printf ("%s : %s init thread create error!\n", __func__, DeviceGRP[i].name);
+            GrpINIT[i].state = eGRP_INIT_NONE;
+            continue;
+        }
+        created[i] = 1;
+    }
+    pthread_mutex_unlock (&GrpMutex);
+
+    for (i = 0; i < eGROUP_END; i++) {
+        if (created[i])
+            pthread_join (GrpINIT[i].thread, NULL);
+    }
+
+    // 다른 thread(lazy mode)에서 실행중인 group init 완료 대기
+    pthread_mutex_lock   (&GrpMutex);
+    for (i = 0; i < eGROUP_END; i++) {
+        while (GrpINIT[i].state == eGRP_INIT_RUN)
+            pthread_cond_wait (&GrpCond, &GrpMutex);
+    }
+    pthread_mutex_unlock (&GrpMutex);
+
+    printf ("%s : all group ready. (%d ms)\n", __func__, elapsed_ms (&start));
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// lazy init mode. group init은 첫 device_check 요청시 해당 group만 실행됨.
+//------------------------------------------------------------------------------
+int device_setup_lazy (void)
+{
+    pthread_mutex_lock   (&GrpMutex);
+    LazyInit = 1;
+    pthread_mutex_unlock (&GrpMutex);
     return 1;
 }
 
@@ -52,6 +52,27 @@ struct msg_info {
     char    end;
 }   __attribute__((packed));
 
+//------------------------------------------------------------------------------
+// response message (total 19 bytes, same size with msg_info)
+//------------------------------------------------------------------------------
+// start | cmd | ui id | grp_id | dev_id | status | resp data | end
+//   @   |  R  |  0000 |    00  |   000  |   1/0  |   000000  | #
+//------------------------------------------------------------------------------
+// ui id, grp_id, dev_id는 request의 값을 그대로 사용하므로, 여러 request를 연속으로
+// 보낸 경우 host는 ui id로 어떤 request의 response인지 구분함. (완료 순서로 응답)
+//------------------------------------------------------------------------------
+#define MSG_START       '@'
+#define MSG_END         '#'
+#define MSG_CMD_CHECK   'C'
+#define MSG_CMD_RESP    'R'
+// protocol version 요청 (extra = version, lib_dev_frame.h 참조)
+#define MSG_CMD_VERSION 'V'
+
+#define SIZE_RESP       SIZE_EXTRA
+
+// 6자리 resp에 들어가지 않는 결과 (full mac, 소수점 포함 값 등). binary frame에서만 전송됨.
+#define SIZE_RESP_EXT   32
+
 //------------------------------------------------------------------------------
 enum {
     eGROUP_SYSTEM = 0,
@@ -81,9 +102,50 @@ enum {
 };
 
 //------------------------------------------------------------------------------
+// Shared resource of the group (bit mask).
+// Groups that use the same resource are initialized one after another,
+// independent groups are initialized at the same time.
 //------------------------------------------------------------------------------
+enum {
+    // block device bus (eMMC, uSD, SATA, NVME)
+    eRES_BLOCK = 0,
+    // usb host controller
+    eRES_USB,
+    // ethernet interface (eth0, iperf server)
+    eRES_ETH0,
+    // efuse (mac address)
+    eRES_EFUSE,
+    // header gpio (sysfs export)
+    eRES_GPIO,
+    // audio codec (aplay)
+    eRES_AUDIO,
+    eRES_END
+};
+
+#define RES_BIT(x)      (1 << (x))
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+extern void device_res_lock     (int res);
+extern void device_res_unlock   (int res);
+extern int  device_grp_ready    (int grp_id);
+extern int  device_resp_msg     (void *msg, int status, const char *resp, void *resp_msg);
+extern int  device_resp_parse   (void *resp_msg, char *resp);
+extern void device_resp_ext     (const char *fmt, ...);
+extern const char *device_resp_ext_get (void);
+extern int  device_msg_grp      (void *msg);
+extern int  device_msg_delay    (void *msg);
+extern int  device_check_run    (void *msg, char *resp);
+extern int  device_check_lane   (void *msg);
 extern int  device_check    (void *msg, char *resp);
 extern int  device_setup    (void);
+extern int  device_setup_lazy   (void);
+
+//------------------------------------------------------------------------------
+#include "lib_dev_frame.h"
+#include "lib_dev_async.h"
+#include "lib_dev_server.h"
+#include "lib_dev_uart.h"
 
 //------------------------------------------------------------------------------
 #endif  // __LIB_DEV_TEST_H__
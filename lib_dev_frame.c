@@ -0,0 +1,520 @@
+//------------------------------------------------------------------------------
+/**
+ * @file lib_dev_frame.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Device Test library for ODROID-JIG. (JIG frame stream codec)
+ * @version 0.2
+ * @date 2023-10-12
+ *
+ * @package apt install iperf3, nmap, ethtool, usbutils, alsa-utils
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+//------------------------------------------------------------------------------
+#include "lib_dev_check.h"
+
+//------------------------------------------------------------------------------
+// crc table (crc16 CCITT-FALSE, crc32 IEEE 802.3)
+//------------------------------------------------------------------------------
+static unsigned short Crc16Table[256];
+static unsigned int   Crc32Table[256];
+static pthread_once_t CrcOnce = PTHREAD_ONCE_INIT;
+
+static void crc_table_init (void)
+{
+    unsigned int i, j, c16, c32;
+
+    for (i = 0; i < 256; i++) {
+        c16 = i << 8;   c32 = i;
+        for (j = 0; j < 8; j++) {
+            c16 = (c16 & 0x8000) ? ((c16 << 1) ^ 0x1021) : (c16 << 1);
+            c32 = (c32 & 0x0001) ? ((c32 >> 1) ^ 0xEDB88320) : (c32 >> 1);
+        }
+        Crc16Table[i] = c16 & 0xFFFF;
+        Crc32Table[i] = c32;
+    }
+}
+
+//------------------------------------------------------------------------------
+unsigned short frame_crc16 (const void *data, int size)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    unsigned short crc = 0xFFFF;
+
+    pthread_once (&CrcOnce, crc_table_init);
+    while (size--)
+        crc = (crc << 8) ^ Crc16Table[((crc >> 8) ^ *p++) & 0xFF];
+    return crc;
+}
+
+//------------------------------------------------------------------------------
+unsigned int frame_crc32 (const void *data, int size)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    unsigned int crc = 0xFFFFFFFF;
+
+    pthread_once (&CrcOnce, crc_table_init);
+    while (size--)
+        crc = (crc >> 8) ^ Crc32Table[(crc ^ *p++) & 0xFF];
+    return crc ^ 0xFFFFFFFF;
+}
+
+//------------------------------------------------------------------------------
+// unsigned LEB128. return encoded size
+//------------------------------------------------------------------------------
+static int varint_put (unsigned char *p, unsigned int value)
+{
+    int n = 0;
+
+    while (value >= 0x80) {
+        p[n++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    p[n++] = value;
+    return n;
+}
+
+//------------------------------------------------------------------------------
+// return decoded size, 0 = need more data, -1 = error
+//------------------------------------------------------------------------------
+static int varint_get (const unsigned char *p, int size, unsigned int *value)
+{
+    unsigned int v = 0;
+    int i;
+
+    for (i = 0; (i < size) && (i < 5); i++) {
+        v |= (unsigned int)(p[i] & 0x7F) << (7 * i);
+        if (!(p[i] & 0x80)) {
+            *value = v;
+            return i +1;
+        }
+    }
+    return (i == 5) ? -1 : 0;
+}
+
+//------------------------------------------------------------------------------
+static void crc_put (unsigned char *p, unsigned int crc, int size)
+{
+    int i;
+
+    for (i = 0; i < size; i++, crc >>= 8)
+        p[i] = crc & 0xFF;
+}
+
+//------------------------------------------------------------------------------
+static unsigned int crc_get (const unsigned char *p, int size)
+{
+    unsigned int crc = 0;
+
+    while (size--)
+        crc = (crc << 8) | p[size];
+    return crc;
+}
+
+//------------------------------------------------------------------------------
+// 고정 길이 10진수 변환. 숫자가 아닌 문자가 있으면 value = 0, return 0.
+// 문자마다 분기하지 않고 error bit만 누적함.
+//------------------------------------------------------------------------------
+int frame_digit (const char *str, int size, int *value)
+{
+    unsigned int v = 0, bad = 0, d;
+    int i;
+
+    for (i = 0; i < size; i++) {
+        d    = (unsigned char)str[i] - '0';
+        bad |= (d > 9);
+        v    = v * 10 + d;
+    }
+    *value = bad ? 0 : (int)v;
+    return !bad;
+}
+
+//------------------------------------------------------------------------------
+// frame(msg_info) 검사 및 field 변환. return 1 = valid frame
+//------------------------------------------------------------------------------
+int frame_decode (const char *frame, struct frame_info *info)
+{
+    const struct msg_info *m_info = (const struct msg_info *)frame;
+    int valid;
+
+    if ((m_info->start != MSG_START) || (m_info->end != MSG_END) ||
+        (m_info->cmd < 'A') || (m_info->cmd > 'Z'))
+        return 0;
+
+    valid  = frame_digit (m_info->ui_id,  SIZE_UI_ID,  &info->ui_id);
+    valid &= frame_digit (m_info->grp_id, SIZE_GRP_ID, &info->grp_id);
+    valid &= frame_digit (m_info->dev_id, SIZE_DEV_ID, &info->dev_id);
+    if (!valid)
+        return 0;
+
+    // extra는 mac data 등 숫자가 아닐 수 있음.
+    if (!frame_digit (m_info->extra, SIZE_EXTRA, &info->extra))
+        info->extra = -1;
+
+    info->cmd    = m_info->cmd;
+    info->action = m_info->action;
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+void frame_codec_init (struct frame_codec *codec)
+{
+    memset (codec, 0, sizeof(struct frame_codec));
+    codec->version = FRAME_V1;
+}
+
+//------------------------------------------------------------------------------
+// binary frame header 검사. return frame size, 0 = need more data, -1 = invalid
+//------------------------------------------------------------------------------
+static int bin_frame_size (const unsigned char *p, int size)
+{
+    unsigned int len;
+    int n, fsize;
+
+    if (size < 2)
+        return 0;
+    if (p[1] & ~(FRAME_BIN_CRC32 | FRAME_BIN_RESP))
+        return -1;
+    if ((n = varint_get (p + 2, size - 2, &len)) <= 0)
+        return n;
+    if (len > FRAME_BIN_PAYLOAD_MAX)
+        return -1;
+
+    // 비정규(길이보다 긴) varint는 codec buffer 크기를 넘을 수 있음
+    fsize = 2 + n + len + ((p[1] & FRAME_BIN_CRC32) ? 4 : 2);
+    return (fsize > FRAME_BIN_SIZE_MAX) ? -1 : fsize;
+}
+
+//------------------------------------------------------------------------------
+// crc 검사 후 request record마다 msg_info frame을 만들어 cb 호출.
+// return record count, -1 = crc error
+//------------------------------------------------------------------------------
+static int bin_frame_decode (struct frame_codec *codec, const unsigned char *p, int fsize,
+                                frame_cb cb, void *arg)
+{
+    char frame[sizeof(struct msg_info) +1];
+    struct frame_info info;
+    const unsigned char *end;
+    unsigned int v[4], crc;
+    int i, n, cnt = 0, csize = (p[1] & FRAME_BIN_CRC32) ? 4 : 2;
+    char action;
+
+    end = p + fsize - csize;
+    crc = (csize == 4) ? frame_crc32 (p +1, end - p -1) : frame_crc16 (p +1, end - p -1);
+    if ((crc != crc_get (end, csize)) || (p[1] & FRAME_BIN_RESP))
+        return -1;
+
+    codec->bin_flags = p[1];
+
+    // payload length
+    p += 2;
+    p += varint_get (p, end - p, &v[0]);
+
+    while (p < end) {
+        // ui_id, grp_id, dev_id, action, extra
+        for (i = 0; i < 3; i++, p += n)
+            if ((n = varint_get (p, end - p, &v[i])) <= 0)
+                goto error;
+        if (p >= end)
+            goto error;
+        action = *p++;
+        if ((n = varint_get (p, end - p, &v[3])) <= 0)
+            goto error;
+        p += n;
+
+        // ascii frame으로 표현할 수 없는 record는 버림.
+        if ((v[0] > 9999) || (v[1] > 99) || (v[2] > 999) || (v[3] > 999999) ||
+            (action < '0') || (action > 'z')) {
+            codec->errors++;
+            continue;
+        }
+        snprintf (frame, sizeof(frame), "%c%c%04u%02u%03u%c%06u%c", MSG_START, MSG_CMD_CHECK,
+                    v[0], v[1], v[2], action, v[3], MSG_END);
+        frame_decode (frame, &info);
+        cb (frame, &info, arg);
+        cnt++;
+    }
+    return cnt;
+error:
+    codec->errors++;
+    return cnt;
+}
+
+//------------------------------------------------------------------------------
+// codec buffer 앞부분 제거. 남은 data가 모두 현재 입력이면 입력에서 바로 처리하도록 되돌림.
+//------------------------------------------------------------------------------
+static void bin_buf_drop (struct frame_codec *codec, int n, int *pos)
+{
+    codec->len -= n;
+    memmove (codec->buf, codec->buf + n, codec->len);
+    if (codec->len <= *pos) {
+        *pos -= codec->len;
+        codec->len = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+// binary stream 입력. 잘못된 frame은 다음 sync 위치부터 다시 동기화 함.
+//------------------------------------------------------------------------------
+static int bin_codec_feed (struct frame_codec *codec, const char *data, int size,
+                            frame_cb cb, void *arg)
+{
+    const unsigned char *p;
+    const char *ptr;
+    int pos = 0, cnt = 0, avail, fsize, used, n;
+
+    while (1) {
+        if (codec->len) {
+            // 이전 입력에서 남은 frame 일부에 이어 붙임
+            n = size - pos;
+            if (n > ((int)sizeof(codec->buf) - codec->len))
+                n = sizeof(codec->buf) - codec->len;
+            memcpy (codec->buf + codec->len, data + pos, n);
+            codec->len += n;    pos += n;
+
+            if ((unsigned char)codec->buf[0] != FRAME_BIN_SYNC) {
+                ptr = memchr (codec->buf +1, FRAME_BIN_SYNC, codec->len -1);
+                n   = (ptr != NULL) ? (ptr - codec->buf) : codec->len;
+                codec->dropped += n;
+                bin_buf_drop (codec, n, &pos);
+                continue;
+            }
+            p = (const unsigned char *)codec->buf;  avail = codec->len;
+        }
+        else {
+            if (pos >= size)
+                break;
+            if ((ptr = memchr (data + pos, FRAME_BIN_SYNC, size - pos)) == NULL) {
+                codec->dropped += size - pos;
+                break;
+            }
+            codec->dropped += (ptr - data) - pos;
+            pos = ptr - data;
+            p = (const unsigned char *)ptr;         avail = size - pos;
+        }
+
+        // frame 일부, 다음 입력 대기
+        if (((fsize = bin_frame_size (p, avail)) == 0) || (fsize > avail)) {
+            if (!codec->len) {
+                memcpy (codec->buf, p, avail);
+                codec->len = avail;
+            }
+            break;
+        }
+
+        if ((fsize > 0) && ((n = bin_frame_decode (codec, p, fsize, cb, arg)) >= 0)) {
+            cnt += n;
+            used = fsize;
+        }
+        else {
+            codec->errors++;
+            codec->dropped++;
+            used = 1;
+        }
+
+        if (codec->len)
+            bin_buf_drop (codec, used, &pos);
+        else
+            pos += used;
+    }
+    return cnt;
+}
+
+//------------------------------------------------------------------------------
+// ascii stream 입력. 잘못된 frame은 다음 '@' 위치부터 다시 동기화 함.
+// version 요청으로 FRAME_V3가 되면 남은 입력은 binary로 처리함.
+//------------------------------------------------------------------------------
+static int ascii_codec_feed (struct frame_codec *codec, const char *data, int size,
+                                frame_cb cb, void *arg)
+{
+    struct frame_info info;
+    const char *ptr;
+    int pos = 0, cnt = 0, fsize = sizeof(struct msg_info);
+
+    // 이전 입력에서 남은 frame 완성
+    while (codec->len && (pos < size)) {
+        int n = fsize - codec->len;
+
+        if (n > (size - pos))
+            n = size - pos;
+
+        memcpy (codec->buf + codec->len, data + pos, n);
+        codec->len += n;    pos += n;
+        if (codec->len < fsize)
+            break;
+
+        if (frame_decode (codec->buf, &info)) {
+            cb (codec->buf, &info, arg);
+            codec->len = 0;
+            cnt++;
+            if (codec->version == FRAME_V3)
+                return cnt + bin_codec_feed (codec, data + pos, size - pos, cb, arg);
+            continue;
+        }
+
+        codec->errors++;
+        if ((ptr = memchr (codec->buf +1, MSG_START, fsize -1)) != NULL) {
+            codec->len      = fsize - (ptr - codec->buf);
+            codec->dropped += fsize - codec->len;
+            memmove (codec->buf, ptr, codec->len);
+        }
+        else {
+            codec->dropped += fsize;
+            codec->len      = 0;
+        }
+    }
+
+    // 입력 buffer에서 바로 decode (copy 없음)
+    while (pos < size) {
+        if ((ptr = memchr (data + pos, MSG_START, size - pos)) == NULL) {
+            codec->dropped += size - pos;
+            break;
+        }
+        codec->dropped += (ptr - data) - pos;
+        pos = ptr - data;
+
+        if ((size - pos) < fsize) {
+            memcpy (codec->buf, data + pos, size - pos);
+            codec->len = size - pos;
+            break;
+        }
+
+        if (frame_decode (data + pos, &info)) {
+            cb (data + pos, &info, arg);
+            pos += fsize;
+            cnt++;
+            if (codec->version == FRAME_V3)
+                return cnt + bin_codec_feed (codec, data + pos, size - pos, cb, arg);
+        }
+        else {
+            codec->errors++;
+            codec->dropped++;
+            pos++;
+        }
+    }
+    return cnt;
+}
+
+//------------------------------------------------------------------------------
+// 임의 크기의 byte stream 입력. 완성된 request frame마다 cb 호출, return frame count.
+// cb의 frame은 항상 ascii frame(msg_info)이며 binary record도 ascii frame으로 변환됨.
+//------------------------------------------------------------------------------
+int frame_codec_feed (struct frame_codec *codec, const char *data, int size,
+                        frame_cb cb, void *arg)
+{
+    int cnt;
+
+    if (codec->version == FRAME_V3)
+        cnt = bin_codec_feed   (codec, data, size, cb, arg);
+    else
+        cnt = ascii_codec_feed (codec, data, size, cb, arg);
+
+    codec->frames += cnt;
+    return cnt;
+}
+
+//------------------------------------------------------------------------------
+// ascii version 요청(MSG_CMD_VERSION) 처리. resp_msg에 response frame(19 bytes)을 만듬.
+// return 1 = 지원하는 version (codec version 변경됨)
+//------------------------------------------------------------------------------
+int frame_version_req (struct frame_codec *codec, const char *frame, void *resp_msg)
+{
+    char resp[SIZE_RESP *2 +1];
+    int version, status;
+
+    frame_digit (((struct msg_info *)frame)->extra, SIZE_EXTRA, &version);
+    status = (version == FRAME_V1) || (version == FRAME_V3);
+    if (status)
+        codec->version = version;
+
+    sprintf (resp, "%06d", codec->version);
+    device_resp_msg ((void *)frame, status, resp, resp_msg);
+    return status;
+}
+
+//------------------------------------------------------------------------------
+// binary response frame. header는 payload 크기가 정해진 후 payload 앞에 만듬.
+//------------------------------------------------------------------------------
+// sync + flags + length(varint max 2 bytes)
+#define BIN_HDR_SPACE   4
+
+void frame_bin_resp_init (struct frame_bin_resp *r)
+{
+    r->len   = BIN_HDR_SPACE;
+    r->count = 0;
+}
+
+//------------------------------------------------------------------------------
+// result record 추가. return 0 = payload full (frame_bin_resp_end 후 다시 추가)
+//------------------------------------------------------------------------------
+int frame_bin_resp_add (struct frame_bin_resp *r, void *msg, int status,
+                        const char *resp, const char *resp_ext)
+{
+    struct msg_info *m_info = (struct msg_info *)msg;
+    unsigned char rec[5 *3 + 2 + SIZE_RESP_EXT];
+    const char *str = ((resp_ext != NULL) && resp_ext[0]) ? resp_ext : resp;
+    int n = 0, len = strlen (str), value;
+
+    if (len > SIZE_RESP_EXT)
+        len = SIZE_RESP_EXT;
+
+    frame_digit (m_info->ui_id,  SIZE_UI_ID,  &value);  n += varint_put (rec + n, value);
+    frame_digit (m_info->grp_id, SIZE_GRP_ID, &value);  n += varint_put (rec + n, value);
+    frame_digit (m_info->dev_id, SIZE_DEV_ID, &value);  n += varint_put (rec + n, value);
+    rec[n++] = status ? 1 : 0;
+    rec[n++] = len;
+    memcpy (rec + n, str, len);     n += len;
+
+    if ((r->len - BIN_HDR_SPACE + n) > FRAME_BIN_PAYLOAD_MAX)
+        return 0;
+
+    memcpy (r->buf + r->len, rec, n);
+    r->len += n;
+    r->count++;
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// response frame 완성. *frame = frame 시작 위치, return frame size (0 = result 없음)
+// frame data는 다음 frame_bin_resp_add 호출 전까지 유효함.
+//------------------------------------------------------------------------------
+int frame_bin_resp_end (struct frame_bin_resp *r, int flags, const char **frame)
+{
+    unsigned char hdr[BIN_HDR_SPACE], *p;
+    int hlen, size;
+
+    if (!r->count)
+        return 0;
+
+    flags  = (flags & FRAME_BIN_CRC32) | FRAME_BIN_RESP;
+    hdr[0] = FRAME_BIN_SYNC;
+    hdr[1] = flags;
+    hlen   = 2 + varint_put (hdr + 2, r->len - BIN_HDR_SPACE);
+
+    p = r->buf + BIN_HDR_SPACE - hlen;
+    memcpy (p, hdr, hlen);
+
+    if (flags & FRAME_BIN_CRC32) {
+        crc_put (r->buf + r->len, frame_crc32 (p +1, r->buf + r->len - p -1), 4);
+        r->len += 4;
+    }
+    else {
+        crc_put (r->buf + r->len, frame_crc16 (p +1, r->buf + r->len - p -1), 2);
+        r->len += 2;
+    }
+
+    *frame = (const char *)p;
+    size   = r->buf + r->len - p;
+    frame_bin_resp_init (r);
+    return size;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,109 @@
+//------------------------------------------------------------------------------
+/**
+ * @file lib_dev_frame.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Device Test library for ODROID-JIG. (JIG frame stream codec)
+ * @version 0.2
+ * @date 2023-10-12
+ *
+ * @package apt install iperf3, nmap, ethtool, usbutils, alsa-utils
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __LIB_DEV_FRAME_H__
+#define __LIB_DEV_FRAME_H__
+
+//------------------------------------------------------------------------------
+// protocol version
+//------------------------------------------------------------------------------
+// v1 : ascii frame (msg_info, 19 bytes). 1 frame = 1 request / 1 response.
+// v3 : binary frame. connect 후 ascii version 요청으로 전환함.
+//      request  "@V" + ui_id + "00" + "000" + "0" + "000003" + "#"
+//      response "@R" + ui_id + "00" + "000" + "1" + "000003" + "#" (0 = not support)
+//
+// binary frame (little endian)
+//  sync | flags | length (varint) | payload (length bytes) | crc16 or crc32
+//  0xB3 |       |                 |                        | (flags ~ payload)
+//
+//  flags bit0 = 1 : crc32 (IEEE 802.3), 0 : crc16 (CCITT-FALSE)
+//  flags bit1 = 1 : response frame
+//
+// request payload  = request record 반복
+//  ui_id (varint) | grp_id (varint) | dev_id (varint) | action (1) | extra (varint)
+//
+// response payload = result record 반복
+//  ui_id (varint) | grp_id (varint) | dev_id (varint) | status (1) | len (1) | resp (len)
+//  resp는 extended resp(device_resp_ext)가 있으면 extended resp, 없으면 resp 문자열.
+//
+// response frame의 crc type은 마지막으로 수신된 request frame과 같음.
+// 완료된 result는 모아서 하나의 response frame으로 전송됨.
+//------------------------------------------------------------------------------
+#define FRAME_V1                1
+#define FRAME_V3                3
+
+#define FRAME_BIN_SYNC          0xB3
+#define FRAME_BIN_CRC32         0x01
+#define FRAME_BIN_RESP          0x02
+
+#define FRAME_BIN_PAYLOAD_MAX   1024
+// sync + flags + length(varint 2 bytes) + payload + crc32
+#define FRAME_BIN_SIZE_MAX      (FRAME_BIN_PAYLOAD_MAX + 8)
+
+//------------------------------------------------------------------------------
+// decoded frame
+struct frame_info {
+    char cmd, action;
+    int  ui_id, grp_id, dev_id;
+    // extra data (-1 = not digit)
+    int  extra;
+};
+
+// frame callback. frame은 msg_info 크기의 원본 frame.
+typedef void (*frame_cb) (const char *frame, struct frame_info *info, void *arg);
+
+struct frame_codec {
+    // FRAME_V1, FRAME_V3
+    int  version;
+    // 마지막으로 수신된 binary frame flags (response crc type)
+    int  bin_flags;
+
+    // 이전 입력에서 남은 frame 일부
+    char buf[FRAME_BIN_SIZE_MAX];
+    int  len;
+
+    // statistics
+    unsigned long frames, errors, dropped;
+};
+
+// binary response frame builder
+struct frame_bin_resp {
+    // frame header 공간 + payload + crc
+    unsigned char buf[FRAME_BIN_SIZE_MAX];
+    int  len;
+    int  count;
+};
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+extern unsigned short frame_crc16   (const void *data, int size);
+extern unsigned int   frame_crc32   (const void *data, int size);
+
+extern int  frame_digit         (const char *str, int size, int *value);
+extern int  frame_decode        (const char *frame, struct frame_info *info);
+extern void frame_codec_init    (struct frame_codec *codec);
+extern int  frame_codec_feed    (struct frame_codec *codec, const char *data, int size,
+                                    frame_cb cb, void *arg);
+extern int  frame_version_req   (struct frame_codec *codec, const char *frame, void *resp_msg);
+
+extern void frame_bin_resp_init (struct frame_bin_resp *r);
+extern int  frame_bin_resp_add  (struct frame_bin_resp *r, void *msg, int status,
+                                    const char *resp, const char *resp_ext);
+extern int  frame_bin_resp_end  (struct frame_bin_resp *r, int flags, const char **frame);
+
+//------------------------------------------------------------------------------
+#endif  // __LIB_DEV_FRAME_H__
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
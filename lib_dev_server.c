@@ -0,0 +1,497 @@
+//------------------------------------------------------------------------------
+/**
+ * @file lib_dev_server.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Device Test library for ODROID-JIG. (JIG frame server / client)
+ * @version 0.2
+ * @date 2023-10-12
+ *
+ * @package apt install iperf3, nmap, ethtool, usbutils, alsa-utils
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+//------------------------------------------------------------------------------
+#include "lib_dev_check.h"
+
+//------------------------------------------------------------------------------
+// 수신된 frame은 async request로 등록되며, response는 완료 순서대로 전송됨.
+// host는 response frame의 ui_id로 어떤 request의 응답인지 구분함.
+//------------------------------------------------------------------------------
+struct server_client {
+    // -1 = connection closed (pending request 완료 후 free)
+    int fd;
+    // receive frame stream
+    struct frame_codec codec;
+    // 처리중인 request 수
+    int pending;
+    // 1 = client list에서 제거됨. (마지막 pending request 완료시 free)
+    int detached;
+
+    // FRAME_V3 response (완료된 result를 모아서 전송)
+    struct frame_bin_resp bin;
+    struct server_client *bin_next;
+    int bin_queued;
+
+    // response tx buffer (non-blocking socket, POLLOUT시 전송)
+    char tx_buf [SERVER_TX_BUF_SIZE];
+    int  tx_len;
+};
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static int unix_listen (const char *path)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if ((fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0)
+        return -1;
+
+    memset (&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy (addr.sun_path, path, sizeof(addr.sun_path) -1);
+
+    unlink (path);
+    if ((bind (fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+        (listen (fd, SERVER_CLIENT_MAX) < 0)) {
+        printf ("%s : %s bind error! (%s)\n", __func__, path, strerror (errno));
+        close (fd);
+        return -1;
+    }
+    return fd;
+}
+
+//------------------------------------------------------------------------------
+static int tcp_listen (int port)
+{
+    struct sockaddr_in addr;
+    int fd, on = 1;
+
+    if ((fd = socket (AF_INET, SOCK_STREAM, 0)) < 0)
+        return -1;
+
+    setsockopt (fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    memset (&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl (INADDR_ANY);
+    addr.sin_port        = htons (port);
+
+    if ((bind (fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+        (listen (fd, SERVER_CLIENT_MAX) < 0)) {
+        printf ("%s : port %d bind error! (%s)\n", __func__, port, strerror (errno));
+        close (fd);
+        return -1;
+    }
+    return fd;
+}
+
+//------------------------------------------------------------------------------
+static int write_all (int fd, const char *buf, int size)
+{
+    int ret, pos = 0;
+
+    while (pos < size) {
+        if ((ret = write (fd, buf + pos, size - pos)) < 0) {
+            if (errno == EINTR)
+                continue;
+            return 0;
+        }
+        pos += ret;
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// tx buffer 전송. return 1 = 남은 data 있음 (POLLOUT 대기)
+// write error는 connection을 닫음. (fd = -1, main loop에서 client 제거)
+//------------------------------------------------------------------------------
+static int client_flush (struct server_client *client)
+{
+    int ret;
+
+    while ((client->fd >= 0) && client->tx_len) {
+        if ((ret = write (client->fd, client->tx_buf, client->tx_len)) < 0) {
+            if (errno == EINTR)
+                continue;
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+                break;
+            close (client->fd);
+            client->fd = -1;
+            client->tx_len = 0;
+            break;
+        }
+        client->tx_len -= ret;
+        memmove (client->tx_buf, client->tx_buf + ret, client->tx_len);
+    }
+    return client->tx_len ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// 1 = client rx 처리 가능 (tx buffer 여유 공간, 처리중인 request 수 확인)
+//------------------------------------------------------------------------------
+static int client_tx_room (struct server_client *client)
+{
+    return (((int)sizeof(client->tx_buf) - client->tx_len) >= SERVER_TX_ROOM) &&
+            (client->pending < SERVER_PENDING_MAX);
+}
+
+//------------------------------------------------------------------------------
+static void client_write (struct server_client *client, const char *data, int size)
+{
+    if (client->fd < 0)
+        return;
+
+    // client_tx_room 확인 후 rx 하므로 response를 읽지 않는 client에서만 발생
+    if ((client->tx_len + size) > (int)sizeof(client->tx_buf)) {
+        printf ("%s : tx buffer overflow! close client. (%d + %d bytes)\n",
+            __func__, client->tx_len, size);
+        close (client->fd);
+        client->fd = -1;
+        client->tx_len = 0;
+        return;
+    }
+    memcpy (&client->tx_buf[client->tx_len], data, size);
+    client->tx_len += size;
+}
+
+//------------------------------------------------------------------------------
+// binary response frame을 tx buffer로 이동
+//------------------------------------------------------------------------------
+static void client_bin_flush (struct server_client *client)
+{
+    const char *frame;
+    int size;
+
+    if ((size = frame_bin_resp_end (&client->bin, client->codec.bin_flags, &frame)) > 0)
+        client_write (client, frame, size);
+}
+
+//------------------------------------------------------------------------------
+// response 추가. FRAME_V1은 바로 tx buffer로, FRAME_V3는 client_bin_flush에서 이동.
+//------------------------------------------------------------------------------
+static void client_send (struct server_client *client, void *msg, int status,
+                            const char *resp, const char *resp_ext)
+{
+    char resp_msg[sizeof(struct msg_info)];
+
+    if (client->codec.version == FRAME_V3) {
+        if (!frame_bin_resp_add (&client->bin, msg, status, resp, resp_ext)) {
+            client_bin_flush (client);
+            frame_bin_resp_add (&client->bin, msg, status, resp, resp_ext);
+        }
+        return;
+    }
+    device_resp_msg (msg, status, resp, resp_msg);
+    client_write (client, resp_msg, sizeof(resp_msg));
+}
+
+//------------------------------------------------------------------------------
+static void client_frame (const char *frame, struct frame_info *info, void *arg)
+{
+    struct server_client *client = (struct server_client *)arg;
+
+    if (info->cmd == MSG_CMD_VERSION) {
+        char resp_msg[sizeof(struct msg_info)];
+
+        // version 변경 전 response는 이전 version으로 전송
+        client_bin_flush (client);
+        frame_version_req (&client->codec, frame, resp_msg);
+        client_write (client, resp_msg, sizeof(resp_msg));
+        return;
+    }
+    if (info->cmd != MSG_CMD_CHECK) {
+        printf ("%s : unknown cmd! (%.*s)\n", __func__, (int)sizeof(struct msg_info), frame);
+        return;
+    }
+
+    if (dev_async_submit ((void *)frame, NULL, client))
+        client->pending++;
+    else {
+        // check는 수 초 이상 걸릴 수 있으므로 poll loop에서 실행하지 않고 바로 fail 응답
+        printf ("%s : async submit error! (%.*s)\n", __func__, (int)sizeof(struct msg_info), frame);
+        client_send (client, (void *)frame, 0, ASYNC_RESP_BUSY, "");
+        client_bin_flush (client);
+    }
+}
+
+//------------------------------------------------------------------------------
+// 수신된 data를 frame단위로 처리. return 0 = client close.
+//------------------------------------------------------------------------------
+static int client_recv (struct server_client *client)
+{
+    char rdata[256];
+    int len;
+
+    if ((len = read (client->fd, rdata, sizeof(rdata))) <= 0)
+        return ((len < 0) && (errno == EINTR || errno == EAGAIN)) ? 1 : 0;
+
+    frame_codec_feed (&client->codec, rdata, len, client_frame, client);
+    return (client->fd >= 0);
+}
+
+//------------------------------------------------------------------------------
+// 완료된 request의 response 전송. FRAME_V3 client는 완료된 result를 모아서 전송.
+//------------------------------------------------------------------------------
+static void client_resp (void)
+{
+    struct dev_async *req;
+    struct server_client *client, *bin_list = NULL;
+
+    while ((req = dev_async_get ()) != NULL) {
+        client = (struct server_client *)req->arg;
+
+        if (client->fd >= 0) {
+            client_send (client, &req->msg, req->status, req->resp, req->resp_ext);
+            if (client->bin.count && !client->bin_queued) {
+                client->bin_queued = 1;
+                client->bin_next   = bin_list;
+                bin_list = client;
+            }
+        }
+        // bin_list의 client는 fd >= 0 이므로 detached 상태가 아님.
+        if ((--client->pending == 0) && client->detached)
+            free (client);
+
+        dev_async_free (req);
+    }
+
+    for (client = bin_list; client != NULL; client = client->bin_next) {
+        client->bin_queued = 0;
+        client_bin_flush (client);
+    }
+}
+
+//------------------------------------------------------------------------------
+static void client_close (struct server_client *client)
+{
+    if (client->fd >= 0)
+        close (client->fd);
+    client->fd = -1;
+
+    if (client->pending)
+        client->detached = 1;
+    else
+        free (client);
+}
+
+//------------------------------------------------------------------------------
+// JIG frame server. device_setup()이 완료된 상태에서 호출되어야 함.
+// unix domain socket, tcp socket으로 수신된 frame을 처리하며 return 되지 않음.
+//------------------------------------------------------------------------------
+int dev_server_run (const char *unix_path, int tcp_port)
+{
+    struct pollfd pfd[SERVER_CLIENT_MAX +3];
+    struct server_client *client[SERVER_CLIENT_MAX];
+    int i, nfds, lfd[2] = { -1, -1 };
+
+    // client가 먼저 끊어진 경우 write error로 처리
+    signal (SIGPIPE, SIG_IGN);
+
+    if (unix_path != NULL)
+        lfd[0] = unix_listen (unix_path);
+    if (tcp_port)
+        lfd[1] = tcp_listen (tcp_port);
+
+    if ((lfd[0] < 0) && (lfd[1] < 0)) {
+        printf ("%s : server socket open error!\n", __func__);
+        return 0;
+    }
+    if (!dev_async_init (0)) {
+        printf ("%s : async init error!\n", __func__);
+        return 0;
+    }
+    printf ("%s : server ready. (unix = %s, tcp port = %d)\n", __func__,
+        (lfd[0] < 0) ? "none" : unix_path, (lfd[1] < 0) ? 0 : tcp_port);
+
+    memset (client, 0, sizeof(client));
+
+    while (1) {
+        nfds = 0;
+        for (i = 0; i < 2; i++) {
+            pfd[nfds].fd = lfd[i];  pfd[nfds].events = POLLIN;  nfds++;
+        }
+        pfd[nfds].fd = dev_async_fd ();  pfd[nfds].events = POLLIN;  nfds++;
+        // tx buffer에 공간이 없는 client는 rx를 멈춤 (다른 client, 완료 request 처리는 계속)
+        for (i = 0; i < SERVER_CLIENT_MAX; i++) {
+            pfd[nfds].fd = (client[i] != NULL) ? client[i]->fd : -1;
+            pfd[nfds].events = (client[i] == NULL) ? 0 :
+                ((client_tx_room (client[i]) ? POLLIN : 0) | (client[i]->tx_len ? POLLOUT : 0));
+            nfds++;
+        }
+
+        if (poll (pfd, nfds, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        // new connection
+        for (i = 0; i < 2; i++) {
+            if (pfd[i].revents & POLLIN) {
+                int fd, c;
+
+                if ((fd = accept (lfd[i], NULL, NULL)) < 0)
+                    continue;
+
+                for (c = 0; c < SERVER_CLIENT_MAX; c++)
+                    if (client[c] == NULL)
+                        break;
+
+                if ((c == SERVER_CLIENT_MAX) ||
+                    ((client[c] = calloc (1, sizeof(struct server_client))) == NULL)) {
+                    printf ("%s : too many client!\n", __func__);
+                    close (fd);
+                    continue;
+                }
+                // response 전송이 poll loop를 막지 않도록 non-blocking
+                fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK);
+                client[c]->fd = fd;
+                frame_codec_init    (&client[c]->codec);
+                frame_bin_resp_init (&client[c]->bin);
+                if (i) {
+                    int on = 1;
+                    setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                }
+            }
+        }
+
+        // completed request
+        if (pfd[2].revents & POLLIN)
+            client_resp ();
+
+        // client request
+        for (i = 0; i < SERVER_CLIENT_MAX; i++) {
+            if (client[i] == NULL)
+                continue;
+
+            if ((client[i]->fd >= 0) && (pfd[i +3].revents & (POLLIN | POLLHUP | POLLERR)) &&
+                !client_recv (client[i])) {
+                client_close (client[i]);
+                client[i] = NULL;
+                continue;
+            }
+            // client tx
+            if (client[i]->tx_len)
+                client_flush (client[i]);
+
+            // response write error로 닫힌 connection
+            if (client[i]->fd < 0) {
+                client_close (client[i]);
+                client[i] = NULL;
+            }
+        }
+    }
+
+    for (i = 0; i < 2; i++)
+        if (lfd[i] >= 0)    close (lfd[i]);
+    if (lfd[0] >= 0)
+        unlink (unix_path);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static int client_connect (const char *addr)
+{
+    const char *port;
+    int fd = -1;
+
+    // "host:port" = tcp, other = unix domain socket path
+    if ((port = strrchr (addr, ':')) != NULL) {
+        struct addrinfo hints, *res, *rp;
+        char host[STR_PATH_LENGTH +1];
+
+        memset (host, 0, sizeof(host));
+        strncpy (host, addr, ((port - addr) < STR_PATH_LENGTH) ? (port - addr) : STR_PATH_LENGTH);
+
+        memset (&hints, 0, sizeof(hints));
+        hints.ai_family   = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        if (getaddrinfo (host, port +1, &hints, &res))
+            return -1;
+
+        for (rp = res; rp != NULL; rp = rp->ai_next) {
+            if ((fd = socket (rp->ai_family, rp->ai_socktype, rp->ai_protocol)) < 0)
+                continue;
+            if (connect (fd, rp->ai_addr, rp->ai_addrlen) == 0) {
+                int on = 1;
+                setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                break;
+            }
+            close (fd);
+            fd = -1;
+        }
+        freeaddrinfo (res);
+    }
+    else {
+        struct sockaddr_un un;
+
+        if ((fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0)
+            return -1;
+
+        memset (&un, 0, sizeof(un));
+        un.sun_family = AF_UNIX;
+        strncpy (un.sun_path, addr, sizeof(un.sun_path) -1);
+
+        if (connect (fd, (struct sockaddr *)&un, sizeof(un)) < 0) {
+            close (fd);
+            fd = -1;
+        }
+    }
+    return fd;
+}
+
+//------------------------------------------------------------------------------
+// server로 1 frame 요청 후 응답 대기. return check status (-1 = error)
+//------------------------------------------------------------------------------
+int dev_client_request (const char *addr, void *msg, char *resp)
+{
+    char resp_msg[sizeof(struct msg_info)];
+    int fd, ret, len = 0, status = -1;
+
+    if ((fd = client_connect (addr)) < 0) {
+        printf ("%s : %s connect error!\n", __func__, addr);
+        return -1;
+    }
+
+    if (write_all (fd, msg, sizeof(struct msg_info))) {
+        while (len < (int)sizeof(resp_msg)) {
+            if ((ret = read (fd, resp_msg + len, sizeof(resp_msg) - len)) <= 0) {
+                if ((ret < 0) && (errno == EINTR))
+                    continue;
+                break;
+            }
+            len += ret;
+        }
+        if (len == sizeof(resp_msg))
+            status = device_resp_parse (resp_msg, resp);
+    }
+    close (fd);
+    return status;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
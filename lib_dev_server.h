@@ -0,0 +1,45 @@
+//------------------------------------------------------------------------------
+/**
+ * @file lib_dev_server.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Device Test library for ODROID-JIG. (JIG frame server / client)
+ * @version 0.2
+ * @date 2023-10-12
+ *
+ * @package apt install iperf3, nmap, ethtool, usbutils, alsa-utils
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __LIB_DEV_SERVER_H__
+#define __LIB_DEV_SERVER_H__
+
+//------------------------------------------------------------------------------
+#define DEFAULT_SERVER_PATH     "/tmp/lib_dev_check.sock"
+
+// max client connection
+#define SERVER_CLIENT_MAX       16
+
+// client별 response tx buffer size
+#define SERVER_TX_BUF_SIZE      (sizeof(struct msg_info) * 1024)
+
+// client rx 처리에 필요한 tx buffer 여유 공간, client별 처리중인 request max.
+// (client가 response를 읽지 않으면 해당 client의 rx를 멈춤)
+#define SERVER_TX_ROOM          (FRAME_BIN_SIZE_MAX * 4)
+#define SERVER_PENDING_MAX      64
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+// unix_path : unix domain socket path (NULL = disable)
+// tcp_port  : tcp listen port (0 = disable)
+extern int  dev_server_run      (const char *unix_path, int tcp_port);
+
+// addr : unix domain socket path or "host:port"
+extern int  dev_client_request  (const char *addr, void *msg, char *resp);
+
+//------------------------------------------------------------------------------
+#endif  // __LIB_DEV_SERVER_H__
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,386 @@
+//------------------------------------------------------------------------------
+/**
+ * @file lib_dev_uart.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Device Test library for ODROID-JIG. (JIG frame uart transport)
+ * @version 0.2
+ * @date 2023-10-12
+ *
+ * @package apt install iperf3, nmap, ethtool, usbutils, alsa-utils
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+// posix_openpt, ptsname
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+
+//------------------------------------------------------------------------------
+#include "lib_dev_check.h"
+
+//------------------------------------------------------------------------------
+// 수신된 frame은 async request로 등록되며 response는 완료 순서대로 전송됨.
+// request마다 thread를 만들지 않고 epoll loop 1개에서 rx/tx/완료를 처리함.
+//------------------------------------------------------------------------------
+struct uart_port {
+    int fd;
+    // pty test mode (slave fd)
+    int pty_fd;
+
+    struct frame_codec codec;
+    // FRAME_V3 response (완료된 result를 모아서 전송)
+    struct frame_bin_resp bin;
+
+    // response tx buffer (non-blocking write)
+    char tx_buf[UART_TX_BUF_SIZE];
+    int  tx_len;
+};
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static speed_t baud_to_speed (int baud)
+{
+    switch (baud) {
+        case 9600:      return B9600;
+        case 19200:     return B19200;
+        case 38400:     return B38400;
+        case 57600:     return B57600;
+        case 115200:    return B115200;
+        case 230400:    return B230400;
+        case 460800:    return B460800;
+        case 500000:    return B500000;
+        case 921600:    return B921600;
+        case 1000000:   return B1000000;
+        case 1500000:   return B1500000;
+        case 2000000:   return B2000000;
+        case 3000000:   return B3000000;
+        case 4000000:   return B4000000;
+        default :
+            printf ("%s : unsupported baud %d, use %d\n", __func__, baud, DEFAULT_UART_BAUD);
+            return B115200;
+    }
+}
+
+//------------------------------------------------------------------------------
+static int uart_raw_mode (int fd, int baud)
+{
+    struct termios tio;
+
+    if (tcgetattr (fd, &tio) < 0)
+        return 0;
+
+    // 8N1, raw, no flow control
+    cfmakeraw (&tio);
+    tio.c_cflag |=  (CLOCAL | CREAD);
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS | PARENB);
+    tio.c_cc[VMIN]  = 1;
+    tio.c_cc[VTIME] = 0;
+
+    cfsetispeed (&tio, baud_to_speed (baud));
+    cfsetospeed (&tio, baud_to_speed (baud));
+
+    tcflush (fd, TCIOFLUSH);
+    return (tcsetattr (fd, TCSANOW, &tio) < 0) ? 0 : 1;
+}
+
+//------------------------------------------------------------------------------
+// return uart fd (non-blocking, raw mode), -1 = error
+//------------------------------------------------------------------------------
+int dev_uart_open (const char *dev, int baud)
+{
+    int fd;
+
+    if ((fd = open (dev, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC)) < 0) {
+        printf ("%s : %s open error! (%s)\n", __func__, dev, strerror (errno));
+        return -1;
+    }
+    if (!uart_raw_mode (fd, baud)) {
+        printf ("%s : %s termios setup error!\n", __func__, dev);
+        close (fd);
+        return -1;
+    }
+    return fd;
+}
+
+//------------------------------------------------------------------------------
+// pseudo terminal 생성. host test program은 출력된 slave device를 사용함.
+//------------------------------------------------------------------------------
+static int uart_pty_open (struct uart_port *port, int baud)
+{
+    const char *slave;
+
+    if ((port->fd = posix_openpt (O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC)) < 0)
+        return 0;
+
+    if ((grantpt (port->fd) < 0) || (unlockpt (port->fd) < 0) ||
+        ((slave = ptsname (port->fd)) == NULL))
+        goto error;
+
+    // slave를 열어두어 host가 연결되지 않은 상태에서도 EIO가 발생하지 않도록 함.
+    if ((port->pty_fd = dev_uart_open (slave, baud)) < 0)
+        goto error;
+
+    printf ("%s : pty slave = %s\n", __func__, slave);
+    return 1;
+error:
+    close (port->fd);
+    port->fd = -1;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// tx buffer 전송. return 1 = 남은 data 있음 (EPOLLOUT 대기), -1 = write error (tx buffer 버림)
+//------------------------------------------------------------------------------
+static int uart_flush (struct uart_port *port)
+{
+    int ret;
+
+    while (port->tx_len) {
+        if ((ret = write (port->fd, port->tx_buf, port->tx_len)) < 0) {
+            if (errno == EINTR)
+                continue;
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+                break;
+            printf ("%s : write error! (%s)\n", __func__, strerror (errno));
+            port->tx_len = 0;
+            return -1;
+        }
+        port->tx_len -= ret;
+        memmove (port->tx_buf, port->tx_buf + ret, port->tx_len);
+    }
+    return port->tx_len ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// 1 = response를 추가할 공간 있음. 공간이 없으면 rx, 완료 request 처리를 멈추고 tx 완료를 기다림.
+//------------------------------------------------------------------------------
+static int uart_tx_room (struct uart_port *port)
+{
+    return ((int)sizeof(port->tx_buf) - port->tx_len) >= UART_TX_ROOM;
+}
+
+//------------------------------------------------------------------------------
+static void uart_tx_add (struct uart_port *port, const char *data, int size)
+{
+    // uart_tx_room 확인 후 호출되므로 발생하지 않음
+    if ((port->tx_len + size) > (int)sizeof(port->tx_buf)) {
+        printf ("%s : tx buffer overflow! (%d + %d bytes)\n", __func__, port->tx_len, size);
+        return;
+    }
+    memcpy (&port->tx_buf[port->tx_len], data, size);
+    port->tx_len += size;
+}
+
+//------------------------------------------------------------------------------
+// binary response frame을 tx buffer로 이동
+//------------------------------------------------------------------------------
+static void uart_bin_flush (struct uart_port *port)
+{
+    const char *frame;
+    int size;
+
+    if ((size = frame_bin_resp_end (&port->bin, port->codec.bin_flags, &frame)) > 0)
+        uart_tx_add (port, frame, size);
+}
+
+//------------------------------------------------------------------------------
+static void uart_resp (struct uart_port *port, void *msg, int status,
+                        const char *resp, const char *resp_ext)
+{
+    char resp_msg[sizeof(struct msg_info)];
+
+    if (port->codec.version == FRAME_V3) {
+        if (!frame_bin_resp_add (&port->bin, msg, status, resp, resp_ext)) {
+            uart_bin_flush (port);
+            frame_bin_resp_add (&port->bin, msg, status, resp, resp_ext);
+        }
+        return;
+    }
+    device_resp_msg (msg, status, resp, resp_msg);
+    uart_tx_add (port, resp_msg, sizeof(resp_msg));
+}
+
+//------------------------------------------------------------------------------
+static void uart_frame (const char *frame, struct frame_info *info, void *arg)
+{
+    struct uart_port *port = (struct uart_port *)arg;
+
+    if (info->cmd == MSG_CMD_VERSION) {
+        char resp_msg[sizeof(struct msg_info)];
+
+        // version 변경 전 response는 이전 version으로 전송
+        uart_bin_flush (port);
+        frame_version_req (&port->codec, frame, resp_msg);
+        uart_tx_add (port, resp_msg, sizeof(resp_msg));
+        return;
+    }
+    if (info->cmd != MSG_CMD_CHECK) {
+        printf ("%s : unknown cmd! (%.*s)\n", __func__, (int)sizeof(struct msg_info), frame);
+        return;
+    }
+
+    if (!dev_async_submit ((void *)frame, NULL, port)) {
+        // check는 수 초 이상 걸릴 수 있으므로 rx 처리중에 실행하지 않고 바로 fail 응답
+        printf ("%s : async submit error! (%.*s)\n", __func__, (int)sizeof(struct msg_info), frame);
+        uart_resp (port, (void *)frame, 0, ASYNC_RESP_BUSY, "");
+        uart_bin_flush (port);
+    }
+}
+
+//------------------------------------------------------------------------------
+static int epoll_set (int efd, int op, int fd, unsigned int events)
+{
+    struct epoll_event ev;
+
+    memset (&ev, 0, sizeof(ev));
+    ev.events  = events;
+    ev.data.fd = fd;
+    return epoll_ctl (efd, op, fd, &ev);
+}
+
+//------------------------------------------------------------------------------
+// hangup (usb-serial 제거, pty 종료), error, write error시 device를 다시 open.
+// return 0 = reopen 실패 (pty는 reopen 하지 않음)
+//------------------------------------------------------------------------------
+static int uart_reopen (struct uart_port *port, int efd, const char *dev, int baud,
+                        unsigned int *port_ev)
+{
+    int retry;
+
+    printf ("%s : %s hangup!\n", __func__, dev);
+    epoll_ctl (efd, EPOLL_CTL_DEL, port->fd, NULL);
+    close (port->fd);
+    port->fd = -1;
+    if (!strcmp (dev, UART_PTY_DEV))
+        return 0;
+
+    for (retry = 0; (retry < UART_REOPEN_RETRY) && (port->fd < 0); retry++) {
+        sleep (1);
+        port->fd = dev_uart_open (dev, baud);
+    }
+    if (port->fd < 0)
+        return 0;
+
+    // 수신중이던 frame은 버림
+    port->codec.len = 0;
+    *port_ev = EPOLLIN;
+    epoll_set (efd, EPOLL_CTL_ADD, port->fd, *port_ev);
+    printf ("%s : %s reopen.\n", __func__, dev);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// JIG frame uart transport. device_setup()이 완료된 상태에서 호출되어야 함.
+// dev = UART_PTY_DEV 인 경우 pseudo terminal로 동작하며 return 되지 않음.
+//------------------------------------------------------------------------------
+int dev_uart_run (const char *dev, int baud)
+{
+    struct uart_port *port;
+    struct epoll_event ev[4];
+    struct dev_async *req;
+    char rdata[256];
+    int efd, afd, i, n, len, hup, tx_wait = 0;
+    unsigned int port_ev, afd_ev, events;
+
+    if ((port = calloc (1, sizeof(struct uart_port))) == NULL)
+        return 0;
+
+    port->fd = port->pty_fd = -1;
+    frame_codec_init    (&port->codec);
+    frame_bin_resp_init (&port->bin);
+
+    if (!strcmp (dev, UART_PTY_DEV)) {
+        if (!uart_pty_open (port, baud))
+            goto error;
+    }
+    else if ((port->fd = dev_uart_open (dev, baud)) < 0)
+        goto error;
+
+    if (!dev_async_init (0) || ((afd = dev_async_fd ()) < 0))
+        goto error;
+
+    if ((efd = epoll_create1 (EPOLL_CLOEXEC)) < 0)
+        goto error;
+
+    port_ev = EPOLLIN;      afd_ev = EPOLLIN;
+    epoll_set (efd, EPOLL_CTL_ADD, port->fd, port_ev);
+    epoll_set (efd, EPOLL_CTL_ADD, afd, afd_ev);
+
+    printf ("%s : uart ready. (%s, %d bps)\n", __func__, dev, baud);
+
+    while (1) {
+        if ((n = epoll_wait (efd, ev, 4, -1)) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        for (hup = 0, i = 0; i < n; i++) {
+            // completed request (tx buffer 공간이 있는 만큼만 처리, 나머지는 queue에 남음)
+            if (ev[i].data.fd == afd) {
+                while (uart_tx_room (port) && ((req = dev_async_get ()) != NULL)) {
+                    uart_resp (port, &req->msg, req->status, req->resp, req->resp_ext);
+                    dev_async_free (req);
+                }
+                uart_bin_flush (port);
+                continue;
+            }
+
+            // uart rx
+            if (ev[i].events & EPOLLIN) {
+                while (uart_tx_room (port) && ((len = read (port->fd, rdata, sizeof(rdata))) > 0))
+                    frame_codec_feed (&port->codec, rdata, len, uart_frame, port);
+            }
+
+            // hangup (usb-serial 제거, pty 종료), error
+            if (ev[i].events & (EPOLLHUP | EPOLLERR)) {
+                hup = 1;
+                break;
+            }
+        }
+        if (hup && !uart_reopen (port, efd, dev, baud, &port_ev))
+            goto hangup;
+
+        // uart tx. write error는 tx buffer를 버리고 hangup과 같이 처리
+        if ((tx_wait = port->tx_len ? uart_flush (port) : 0) < 0) {
+            if (!uart_reopen (port, efd, dev, baud, &port_ev))
+                goto hangup;
+            tx_wait = 0;
+        }
+
+        // tx buffer에 공간이 없으면 rx, 완료 request 처리를 멈춤 (response를 버리지 않음)
+        events = (uart_tx_room (port) ? EPOLLIN : 0) | (tx_wait ? EPOLLOUT : 0);
+        if (events != port_ev) {
+            port_ev = events;
+            epoll_set (efd, EPOLL_CTL_MOD, port->fd, port_ev);
+        }
+        events = uart_tx_room (port) ? EPOLLIN : 0;
+        if (events != afd_ev) {
+            afd_ev = events;
+            epoll_set (efd, EPOLL_CTL_MOD, afd, afd_ev);
+        }
+    }
+hangup:
+    close (efd);
+error:
+    printf ("%s : %s uart error!\n", __func__, dev);
+    if (port->fd >= 0)      close (port->fd);
+    if (port->pty_fd >= 0)  close (port->pty_fd);
+    free (port);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
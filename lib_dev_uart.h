@@ -0,0 +1,43 @@
+//------------------------------------------------------------------------------
+/**
+ * @file lib_dev_uart.h
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief Device Test library for ODROID-JIG. (JIG frame uart transport)
+ * @version 0.2
+ * @date 2023-10-12
+ *
+ * @package apt install iperf3, nmap, ethtool, usbutils, alsa-utils
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#ifndef __LIB_DEV_UART_H__
+#define __LIB_DEV_UART_H__
+
+//------------------------------------------------------------------------------
+#define DEFAULT_UART_DEV    "/dev/ttyS0"
+#define DEFAULT_UART_BAUD   115200
+
+// uart device 이름을 "pty"로 설정하면 pseudo terminal을 생성함. (test용)
+#define UART_PTY_DEV        "pty"
+
+// response tx buffer size
+#define UART_TX_BUF_SIZE    (sizeof(struct msg_info) * 1024)
+
+// rx, 완료 request 처리에 필요한 tx buffer 여유 공간 (binary response frame 2개 이상)
+#define UART_TX_ROOM        (FRAME_BIN_SIZE_MAX * 4)
+
+// hangup 후 device reopen 시도 횟수 (1초 간격)
+#define UART_REOPEN_RETRY   10
+
+//------------------------------------------------------------------------------
+// function prototype
+//------------------------------------------------------------------------------
+extern int  dev_uart_open   (const char *dev, int baud);
+extern int  dev_uart_run    (const char *dev, int baud);
+
+//------------------------------------------------------------------------------
+#endif  // __LIB_DEV_UART_H__
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
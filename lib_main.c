@@ -162,7 +162,11 @@ static void toupperstr (char *p)
 static void print_usage (const char *prog)
 {
     puts("");
-    printf("Usage: %s [-g:group] [-d:dev id] [-a:action]\n", prog);
+    printf("Usage: %s [-g:group] [-d:dev id] [-a:action] [-f]\n", prog);
+    printf("       %s [-s:unix socket path] [-p:tcp port]\n", prog);
+    printf("       %s [-c:server addr] [-g:group] [-d:dev id] [-a:action]\n", prog);
+    printf("       %s [-u:uart device] [-r:baud rate]\n", prog);
+    printf("       %s [-b:frame count]\n", prog);
     puts("\n"
          "Protocol)\n"
          "https://docs.google.com/spreadsheets/d/1Of7im-2I5m_M-YKswsubrzQAXEGy-japYeH8h_754WA/edit#gid=0\n"
@@ -170,9 +174,25 @@ static void print_usage (const char *prog)
          "  -g --group id     Group ID(0~99)\n"
          "  -d --device id    Device ID(0~999)\n"
          "  -a --action       Action(Clear/Set/Link/Read/Write/Init/0~9)\n"
+         "  -f --full_init    Init all groups before check.\n"
+         "                    (default : init only the requested group)\n"
+         "\n"
+         "  -s --server       Server mode. Init all groups once and answer\n"
+         "                    the JIG frames over the unix domain socket.\n"
+         "  -p --port         Server mode tcp port. (0 = disable)\n"
+         "  -c --connect      Client mode. Send the frame to the server.\n"
+         "                    (unix socket path or host:port)\n"
+         "  -u --uart         UART mode. Init all groups once and answer\n"
+         "                    the JIG frames over the uart device.\n"
+         "                    (\"" UART_PTY_DEV "\" = create pseudo terminal for test)\n"
+         "  -r --baud         UART mode baud rate. (default 115200)\n"
+         "  -b --bench        Frame codec benchmark.\n"
          "\n"
          "  e.g) system memory read.\n"
          "       lib_dev_test -g 0 -d 0 -a r\n"
+         "       lib_dev_test -s " DEFAULT_SERVER_PATH " -p 8888\n"
+         "       lib_dev_test -c " DEFAULT_SERVER_PATH " -g 0 -d 0 -a r\n"
+         "       lib_dev_test -u " DEFAULT_UART_DEV " -r 115200\n"
     );
     exit(1);
 }
@@ -182,6 +202,13 @@ static void print_usage (const char *prog)
 //------------------------------------------------------------------------------
 static char OPT_ACTION    = 0;
 static char OPT_VIEW_INFO = 0;
+static char OPT_FULL_INIT = 0;
+static int  OPT_TCP_PORT  = 0;
+static char *OPT_SERVER   = NULL;
+static char *OPT_CONNECT  = NULL;
+static int  OPT_BENCH     = 0;
+static char *OPT_UART     = NULL;
+static int  OPT_BAUD      = DEFAULT_UART_BAUD;
 static int  OPT_GROUP_ID  = 0;
 static int  OPT_DEVICE_ID = 0;
 
@@ -194,11 +221,18 @@ static void parse_opts (int argc, char *argv[])
             { "device_id",  1, 0, 'd' },
             { "action"   ,  1, 0, 'a' },
             { "view"     ,  0, 0, 'v' },
+            { "full_init",  0, 0, 'f' },
+            { "server"   ,  1, 0, 's' },
+            { "port"     ,  1, 0, 'p' },
+            { "connect"  ,  1, 0, 'c' },
+            { "bench"    ,  1, 0, 'b' },
+            { "uart"     ,  1, 0, 'u' },
+            { "baud"     ,  1, 0, 'r' },
             { NULL, 0, 0, 0 },
         };
         int c;
 
-        c = getopt_long(argc, argv, "g:d:a:vh", lopts, NULL);
+        c = getopt_long(argc, argv, "g:d:a:vfs:p:c:b:u:r:h", lopts, NULL);
 
         if (c == -1)
             break;
@@ -217,6 +251,27 @@ static void parse_opts (int argc, char *argv[])
         case 'v':
             OPT_VIEW_INFO = 1;
             break;
+        case 'f':
+            OPT_FULL_INIT = 1;
+            break;
+        case 's':
+            OPT_SERVER = optarg;
+            break;
+        case 'p':
+            OPT_TCP_PORT = atoi(optarg);
+            break;
+        case 'c':
+            OPT_CONNECT = optarg;
+            break;
+        case 'b':
+            OPT_BENCH = atoi(optarg);
+            break;
+        case 'u':
+            OPT_UART = optarg;
+            break;
+        case 'r':
+            OPT_BAUD = atoi(optarg);
+            break;
         case 'h':
         default:
             print_usage(argv[0]);
@@ -239,11 +294,127 @@ void make_msg (char *msg, int grp_id, int dev_id, char action)
     printf ("make msg = %s, size = %ld\n", msg, sizeof(struct msg_info));
 }
 
+//------------------------------------------------------------------------------
+//
+// frame codec benchmark
+//
+//------------------------------------------------------------------------------
+static void bench_frame (const char *frame, struct frame_info *info, void *arg)
+{
+    (void)frame;
+    *(long *)arg += info->grp_id + info->dev_id + info->extra;
+}
+
+//------------------------------------------------------------------------------
+static double bench_ms (struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return  (now.tv_sec  - start->tv_sec)  * 1000. +
+            (now.tv_nsec - start->tv_nsec) / 1000000.;
+}
+
+//------------------------------------------------------------------------------
+// 이전 방식 (memcpy + atoi)
+static int bench_atoi (char *str, int str_size)
+{
+    char conv[10];
+
+    memset (conv, 0, sizeof(conv));
+    memcpy (conv, str, str_size);
+    return atoi (conv);
+}
+
+//------------------------------------------------------------------------------
+static void codec_bench (int count)
+{
+    struct frame_codec codec;
+    struct timespec start;
+    struct msg_info *m_info;
+    char *stream;
+    long sum = 0;
+    int i, pos, len, size = count * (sizeof(struct msg_info) +4);
+    double ms;
+
+    if ((stream = malloc (size)) == NULL)
+        return;
+
+    // 16 frame마다 noise 추가
+    for (i = 0, pos = 0; i < count; i++) {
+        pos += sprintf (&stream[pos], "@C%04d%02d%03d%c%06d#",
+                    i % 10000, i % eGROUP_END, i % 4, "RWLI"[i % 4], 0);
+        if (!(i % 16))
+            pos += sprintf (&stream[pos], "x\r\n");
+    }
+    size = pos;
+
+    // UART read와 같이 1 ~ 64 bytes 단위로 입력
+    frame_codec_init (&codec);
+    srand (0);
+    clock_gettime (CLOCK_MONOTONIC, &start);
+    for (pos = 0; pos < size; pos += len) {
+        len = (rand () % 64) + 1;
+        if (len > size - pos)
+            len = size - pos;
+        frame_codec_feed (&codec, &stream[pos], len, bench_frame, &sum);
+    }
+    ms = bench_ms (&start);
+    printf ("codec stream : %lu frames, %lu errors, %lu dropped bytes, %.1f ms, %.1f MB/s, %.0f frames/s\n",
+        codec.frames, codec.errors, codec.dropped, ms,
+        size / ms / 1000., codec.frames / ms * 1000.);
+
+    // 정렬된 frame만 사용하는 이전 방식과 field decode 비교
+    for (i = 0, pos = 0; i < count; i++) {
+        pos += sprintf (&stream[pos], "@C%04d%02d%03d%c%06d#",
+                    i % 10000, i % eGROUP_END, i % 4, "RWLI"[i % 4], 0);
+    }
+
+    clock_gettime (CLOCK_MONOTONIC, &start);
+    for (i = 0; i < count; i++) {
+        m_info = (struct msg_info *)&stream[i * sizeof(struct msg_info)];
+        sum += bench_atoi (m_info->grp_id, SIZE_GRP_ID) +
+               bench_atoi (m_info->dev_id, SIZE_DEV_ID) +
+               bench_atoi (m_info->extra,  SIZE_EXTRA);
+    }
+    ms = bench_ms (&start);
+    printf ("decode atoi  : %d frames, %.1f ms, %.0f frames/s\n", count, ms, count / ms * 1000.);
+
+    clock_gettime (CLOCK_MONOTONIC, &start);
+    for (i = 0; i < count; i++) {
+        struct frame_info info;
+
+        if (frame_decode (&stream[i * sizeof(struct msg_info)], &info))
+            sum += info.grp_id + info.dev_id + info.extra;
+    }
+    ms = bench_ms (&start);
+    printf ("decode codec : %d frames, %.1f ms, %.0f frames/s (%ld)\n", count, ms, count / ms * 1000., sum);
+
+    free (stream);
+}
+
 //------------------------------------------------------------------------------
 int main (int argc, char *argv[])
 {
     parse_opts(argc, argv);
 
+    if (OPT_BENCH) {
+        codec_bench (OPT_BENCH);
+        return 0;
+    }
+
+    // server mode : init 값을 유지한 상태로 frame 요청을 처리함.
+    if (OPT_SERVER || OPT_TCP_PORT) {
+        device_setup ();
+        return dev_server_run (OPT_SERVER, OPT_TCP_PORT) ? 0 : 1;
+    }
+
+    // uart mode
+    if (OPT_UART) {
+        device_setup ();
+        return dev_uart_run (OPT_UART, OPT_BAUD) ? 0 : 1;
+    }
+
     if (argc < 7)
         print_usage(argv[0]);
 
@@ -266,7 +437,17 @@ int main (int argc, char *argv[])
 
         make_msg (msg, OPT_GROUP_ID, OPT_DEVICE_ID, OPT_ACTION);
 
-        device_setup();
+        // client mode
+        if (OPT_CONNECT) {
+            ret = dev_client_request (OPT_CONNECT, msg, resp);
+            printf ("resp = %s, return = %d\n", resp, ret);
+            return (ret < 0) ? 1 : 0;
+        }
+
+        if (OPT_FULL_INIT)
+            device_setup ();
+        else
+            device_setup_lazy ();
         ret = device_check (msg, resp);
         if (OPT_GROUP_ID == eGROUP_AUDIO)
             sleep (3);